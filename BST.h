@@ -1,6 +1,26 @@
 #include <cstddef>
 #include <stdio.h>
 #include <exception>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <atomic>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#ifdef BST_THREAD_SAFE
+#include <mutex>
+#include <shared_mutex>
+#endif
 /////////////////////////////////////////////////
 /// @mainpage Welcome to the Autobalancing BST Library
 /// @description The purpose of this library is to
@@ -14,6 +34,101 @@
 #ifndef __BST__
 #define __BST__
 
+/////////////////////////////////////////////////
+/// Optional thread safety
+/// Define `BST_THREAD_SAFE` before including this header to guard
+/// every tree-level operation with a reader-writer lock: lookups and
+/// traversals take a shared lock and scale across cores, while
+/// `insert`/`deleteNode`/`clear`/`balance` take an exclusive lock.
+/// The raw-node overloads (`findMinimum(Node<K, T>*)`) remain
+/// unsynchronized, and although `getRoot()` reads the root under
+/// the lock, any interior pointer is stale once a structural
+/// rebuild (`insertBatch`, `compact`, `split`, `balance`) runs;
+/// callers holding raw nodes across writes need their own fencing.
+/// Without the define the lock macros compile away to nothing
+/////////////////////////////////////////////////
+
+#ifdef BST_THREAD_SAFE
+#define BST_READ_LOCK std::shared_lock<std::shared_mutex> bstGuard(this->treeMutex)
+#define BST_WRITE_LOCK std::unique_lock<std::shared_mutex> bstGuard(this->treeMutex)
+#else
+#define BST_READ_LOCK
+#define BST_WRITE_LOCK
+#endif
+
+/////////////////////////////////////////////////
+/// Optional instrumentation
+/// Define `BST_STATS` before including this header to have the hot
+/// paths keep running counters (comparisons, descent depths,
+/// rotations, allocator activity) that `getStats()` snapshots for a
+/// metrics pipeline. The counters are relaxed atomics, so readers
+/// sharing the lock under `BST_THREAD_SAFE` tick them without
+/// racing. Without the define the counting statements compile away
+/// entirely and `getStats()` still reports the O(1) structural
+/// fields (node count, height, slabs)
+/////////////////////////////////////////////////
+
+#ifdef BST_STATS
+#define BST_STAT(expression) expression
+#else
+#define BST_STAT(expression)
+#endif
+
+/////////////////////////////////////////////////
+/// Optional software prefetching
+/// Define `BST_PREFETCH` before including this header to have the
+/// descent loops issue prefetches for all four grandchildren of the
+/// current node, two levels ahead of the comparison being resolved.
+/// Prefetching only the immediate children would overlap a miss
+/// with just the few cycles of the current comparison; fetching the
+/// grandchildren keeps a full level of misses in flight, and in
+/// steady state the children's lines were already requested one
+/// iteration earlier, so reading their pointers to aim the next
+/// prefetches does not stall. Worth A/B-ing with the benchmark
+/// suite (`make run-prefetch` in bench/) — it helps once the tree
+/// outgrows the caches and is neutral noise before that
+/////////////////////////////////////////////////
+
+#if defined(BST_PREFETCH) && (defined(__GNUC__) || defined(__clang__))
+#define BST_PREFETCH_CHILDREN(node) \
+  do { \
+    auto* bstPrefetchLeft = (node)->left; \
+    auto* bstPrefetchRight = (node)->right; \
+    if(bstPrefetchLeft) { \
+      if(bstPrefetchLeft->left) __builtin_prefetch(bstPrefetchLeft->left); \
+      if(bstPrefetchLeft->right) __builtin_prefetch(bstPrefetchLeft->right); \
+    } \
+    if(bstPrefetchRight) { \
+      if(bstPrefetchRight->left) __builtin_prefetch(bstPrefetchRight->left); \
+      if(bstPrefetchRight->right) __builtin_prefetch(bstPrefetchRight->right); \
+    } \
+  } while(0)
+#else
+#define BST_PREFETCH_CHILDREN(node)
+#endif
+
+/////////////////////////////////////////////////
+/// Tree Health Snapshot
+/// Filled by `BST<K, T, Compare>::getStats()`. The structural
+/// fields cost O(1) and are always exact; the counter fields are
+/// only maintained when the header is compiled with `BST_STATS`
+/// and read zero otherwise
+/// @author Derick Vigne
+/// @copyright MIT License
+/////////////////////////////////////////////////
+
+struct BSTStats {
+  size_t nodeCount; //!< Nodes currently in the tree
+  int height; //!< Height of the tree
+  size_t slabCount; //!< Arena slabs currently allocated
+  unsigned long long comparisons; //!< Comparator invocations on the descent paths
+  unsigned long long descents; //!< Lookup/insert/delete descents performed
+  unsigned long long deepestDescent; //!< Longest descent observed
+  unsigned long long rotations; //!< AVL rotations performed
+  unsigned long long allocations; //!< Nodes handed out from fresh slab slots
+  unsigned long long recycles; //!< Nodes handed out from the free-list
+};
+
 /////////////////////////////////////////////////
 /// Out of Bounds Derived Structure
 /// Throws `const char * "Supplied weight is out of tree bounds"` if a requested operation cannot be completed given the weight
@@ -28,6 +143,55 @@ struct OutOfBoundsException : public std::exception {
   }
 };
 
+/////////////////////////////////////////////////
+/// Subtree Aggregate Policies
+/// The `Aggregate` template parameter on `Node` and `BST` selects a
+/// monoid folded over every subtree and kept current by the same
+/// `pullUp` that maintains heights and sizes, so
+/// `aggregateRange(lo, hi)` can answer range queries from O(log n)
+/// precomputed summaries instead of walking the entries. A policy
+/// supplies the element type `Value`, an `identity()`, a `lift()`
+/// from the stored value and an associative `combine()`; folds run
+/// left-to-right in weight order, so non-commutative monoids work.
+/// The default `BSTNoAggregate` stores and computes nothing
+/// @author Derick Vigne
+/// @copyright MIT License
+/////////////////////////////////////////////////
+
+struct BSTEmptyAggregate {}; //!< Zero-size stand-in stored when no aggregate is wanted
+
+template <class T>
+struct BSTNoAggregate {
+  typedef BSTEmptyAggregate Value; //!< Nothing is stored per node
+  static Value identity() { return Value(); }
+  static Value lift(const T&) { return Value(); }
+  static Value combine(const Value&, const Value&) { return Value(); }
+};
+
+template <class T>
+struct BSTSumAggregate {
+  typedef T Value; //!< Running sum of the subtree's values
+  static Value identity() { return T(); }
+  static Value lift(const T& value) { return value; }
+  static Value combine(const Value& a, const Value& b) { return a + b; }
+};
+
+template <class T>
+struct BSTMinAggregate {
+  typedef T Value; //!< Smallest value in the subtree
+  static Value identity() { return std::numeric_limits<T>::max(); }
+  static Value lift(const T& value) { return value; }
+  static Value combine(const Value& a, const Value& b) { return b < a ? b : a; }
+};
+
+template <class T>
+struct BSTMaxAggregate {
+  typedef T Value; //!< Largest value in the subtree
+  static Value identity() { return std::numeric_limits<T>::lowest(); }
+  static Value lift(const T& value) { return value; }
+  static Value combine(const Value& a, const Value& b) { return a < b ? b : a; }
+};
+
 /////////////////////////////////////////////////
 /// Node Object Structure
 /// Used to create nodes that get autobalanced by the BST class
@@ -35,324 +199,3056 @@ struct OutOfBoundsException : public std::exception {
 /// @copyright MIT License
 /////////////////////////////////////////////////
 
-template <class T>
+template <class K, class T = K, class Aggregate = BSTNoAggregate<T>>
 class Node {
 public:
-  int weight = 0; //!< Weight of the node
-  T value = 0; //!< Value of the the node
-  Node<T> *left, *right, *parent = NULL;
+  K weight; //!< Weight of the node, any type orderable by the tree's comparator
+  T value; //!< Value of the the node
+  int height = 1; //!< Height of the subtree rooted at this node, maintained by the AVL machinery
+  size_t size = 1; //!< Number of nodes in the subtree rooted at this node, maintained alongside height
+  bool dead = false; //!< Tombstone flag set by `markDeleted`, cleared when the weight is reinserted
+  typename Aggregate::Value aggregate; //!< Fold of this subtree's live values under the aggregate policy
+  std::vector<T>* extras = NULL; //!< Overflow values when the weight holds duplicates, NULL for the common single-value node
+  Node<K, T, Aggregate> *left = NULL, *right = NULL, *parent = NULL;
 
 /////////////////////////////////////////////////
-/// @var Node<T> *left
+/// @var Node<K, T> *left
 /// @brief Left node in reference to current node
-/// @var Node<T> *right
+/// @var Node<K, T> *right
 /// @brief Right node in reference to current node
-/// @var Node<T> *parent
+/// @var Node<K, T> *parent
 /// @brief Parent node in reference to current node
 /////////////////////////////////////////////////
 
-  Node(int weight, T value);
+  template <class... Args>
+  Node(K weight, Args&&... args);
+  ~Node() { delete extras; }
 };
 
 /////////////////////////////////////////////////
-/// BST class
-/// Autobalancing Binary Search Tree Library
+/// Frozen Read-Only Snapshot
+/// Immutable copy of a `BST<T>` with weights stored in Eytzinger
+/// (BFS) order in one contiguous array and values in a parallel
+/// array, so a lookup touches one predictable cache line per level
+/// instead of chasing node pointers. Built via `BST<K, T, Compare>::freeze()`
 /// @author Derick Vigne
 /// @copyright MIT License
 /////////////////////////////////////////////////
 
-template <class T>
-class BST {
+template <class K, class T = K, class Compare = std::less<K>>
+class FrozenBST {
 private:
-  Node<T>* root; // Root node created when the BST() constructor is executed
-  void replace_node_in_parent(Node<T> *currentNode, Node<T> *newNode);
-  bool weightInbounds(Node<T>* root, int weight); ///< Check if supplised weight is in bounds
+  K* weights = NULL; ///< Weights in Eytzinger order
+  Compare comp; ///< Ordering used for lookups, matching the source tree
+  T* values = NULL; ///< Values parallel to the weights array
+  size_t count = 0; ///< Number of entries
+  void fill(const std::pair<K, T>* sorted, size_t& cursor, size_t index); ///< Recursive Eytzinger placement
 
 public:
-  BST(int weight, T value) { this->root = new Node<T>(weight, value); }
-  Node<T>* search(Node<T> *root, T value); ///< Returns pointer to node with value
-  Node<T>* getNode(Node<T>* root, int weight); ///< Returns pointer to node of given weight
-  Node<T>* insert(Node<T>* root, int weight, T value); ///< Inserts a value auto-balancing a tree
-  void traverse(Node<T>* root, void (*callback)(int)); ///< Traverse to node based on weight
-  void deleteNode(Node<T> *currentNode, int weight); ///< Deletes a node and rebalances the tree
-  Node<T>* balance(); ///< Performs a manual balance of the tree
-  Node<T>* findMinimum(); ///< Finds the global minimum
-  Node<T>* findMaximum(); ///< Finds the global maximum
-  Node<T>* findMinimum(Node<T>* root); ///< Finds the minimum given a node
-  Node<T>* findMaximum(Node<T>* root); ///< Finds the maximum given a node
-  Node<T>* getRoot(); ///< Returns the root of the BST
-  bool isBalanced(Node<T>* root, int minWeight, int maxWeight); ///< Verify the BST is balanced
+  FrozenBST(const std::pair<K, T>* sorted, size_t count); ///< Builds the snapshot from a sorted array
+  FrozenBST(FrozenBST&& other);
+  FrozenBST(const FrozenBST&) = delete;
+  ~FrozenBST();
+  T& getFrozen(K weight); ///< Branch-free lookup of a value by weight
+  size_t size() { return count; } ///< Number of entries in the snapshot
 };
 
 /////////////////////////////////////////////////
-/// @fn BST<T>::BST(int weight, T value)
-/// @brief Constructor
-///
-/// Used to bootstrap and create
-/// the first root node of the BST
-/// @param weight Sets the weight of the new root node
-/// @param value Sets the value of the new root node
+/// @param sorted Array of pairs sorted ascending by weight
+/// @param cursor Next sorted entry to place, advanced in-order
+/// @param index Eytzinger slot being filled
 /// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare>
+void FrozenBST<K, T, Compare>::fill(const std::pair<K, T>* sorted, size_t& cursor, size_t index) {
+  if(index >= count) {
+    return;
+  }
+  fill(sorted, cursor, 2 * index + 1);
+  weights[index] = sorted[cursor].first;
+  values[index] = sorted[cursor].second;
+  cursor++;
+  fill(sorted, cursor, 2 * index + 2);
+}
 
 /////////////////////////////////////////////////
-/// @brief Constructor used to create a node
-/// @param weight weight of the node
-/// @param value value of the node
+/// @param sorted Array of pairs sorted ascending by weight
+/// @param count Number of pairs in the array
 /// @return `void`
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>::Node(int weight, T value) {
-  this->weight = weight;
-  this->value = value;
+template <class K, class T, class Compare>
+FrozenBST<K, T, Compare>::FrozenBST(const std::pair<K, T>* sorted, size_t count) {
+  this->count = count;
+  this->weights = new K[count];
+  this->values = new T[count];
+  size_t cursor = 0;
+  fill(sorted, cursor, 0);
+}
+
+template <class K, class T, class Compare>
+FrozenBST<K, T, Compare>::FrozenBST(FrozenBST&& other) {
+  weights = other.weights;
+  values = other.values;
+  count = other.count;
+  other.weights = NULL;
+  other.values = NULL;
+  other.count = 0;
+}
+
+template <class K, class T, class Compare>
+FrozenBST<K, T, Compare>::~FrozenBST() {
+  delete[] weights;
+  delete[] values;
 }
 
 /////////////////////////////////////////////////
-/// @param root Current node to begin searching from
-/// @param value Value to search for
-/// @return `Node<T>*` Returns pointer to found node
+/// @description Descends the implicit Eytzinger tree with a
+/// branch-free loop: each step computes `2i + 1 + (weights[i] < w)`
+/// with no data-dependent branch, so the hardware prefetcher and
+/// speculation stay busy. The final index is recovered from the
+/// trailing bits of the virtual position
+/// @param weight Weight to look up
+/// @return `T&` Reference to the value stored under `weight`
+/// @throws OutOfBoundsException If the weight is not present
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::search(Node<T>* root, T value) {
-  if (value < this->findMinimum()->value || value > this->findMaximum()->value) {
-    return root;
-  }
-  if(root->value == value) {
-    return root;
+template <class K, class T, class Compare>
+T& FrozenBST<K, T, Compare>::getFrozen(K weight) {
+  size_t index = 0;
+  while(index < count) {
+    index = 2 * index + 1 + comp(weights[index], weight);
   }
-  if(value < root->value) {
-    return this->search(root->left, value);
+  index = ((index + 1) >> __builtin_ffsll(~(index + 1))) - 1;
+  if(index == (size_t) -1 || comp(weights[index], weight) || comp(weight, weights[index])) {
+    throw OutOfBoundsException();
   }
-  return this->search(root->right, value);
+  return values[index];
 }
 
 /////////////////////////////////////////////////
-/// @param root Current node to begin traversing from
-/// @param weight Weight to check
-/// @return `bool`
+/// Blocked Read-Only Snapshot
+/// Immutable copy of a `BST<T>` in a static B+-tree layout: the
+/// keys live sorted in blocks of sixteen with sampled fence keys
+/// stacked above them, so every cache line touched on a descent
+/// carries sixteen useful weights instead of one key and three
+/// pointers, and the tree is roughly a quarter the height of the
+/// node-per-key layouts. Within a block the search is a branch-free
+/// count-of-smaller scan the compiler auto-vectorizes for primitive
+/// `K`. Built via `BST<K, T, Compare>::freezeBlocked()`
+/// @author Derick Vigne
+/// @copyright MIT License
 /////////////////////////////////////////////////
-template <class T>
-bool BST<T>::weightInbounds(Node<T>* root, int weight) {
-  return weight >= findMinimum(root)->weight && weight <= findMaximum(root)->weight;
-}
+
+template <class K, class T = K, class Compare = std::less<K>>
+class BlockedBST {
+private:
+  static const size_t BLOCK_KEYS = 16; ///< Keys per block, one cache line of 32-bit weights
+  static const int MAX_LEVELS = 16; ///< Fence levels needed to cover any 64-bit count
+  K* weights = NULL; ///< All weights, sorted ascending
+  Compare comp; ///< Ordering used for lookups, matching the source tree
+  T* values = NULL; ///< Values parallel to the weights array
+  K* fences = NULL; ///< Fence levels concatenated bottom-up, each sampling the block maxima below
+  size_t levelOffset[MAX_LEVELS]; ///< Start of each fence level inside `fences`
+  size_t levelCount[MAX_LEVELS]; ///< Number of fence keys on each level
+  int levels = 0; ///< Number of fence levels above the sorted keys
+  size_t count = 0; ///< Number of entries
+  size_t scanBlock(const K* keys, size_t len, K weight); ///< Branch-free count of keys below `weight`
+
+public:
+  BlockedBST(const std::pair<K, T>* sorted, size_t count); ///< Builds the snapshot from a sorted array
+  BlockedBST(BlockedBST&& other);
+  BlockedBST(const BlockedBST&) = delete;
+  ~BlockedBST();
+  T& getBlocked(K weight); ///< Block-at-a-time lookup of a value by weight
+  size_t size() { return count; } ///< Number of entries in the snapshot
+};
 
 /////////////////////////////////////////////////
-/// @param root Current node to begin traversing from
-/// @param weight Weight of node to fetch
-/// @return `Node<T>*` Pointer to node
+/// @param sorted Array of pairs sorted ascending by weight
+/// @param count Number of pairs in the array
+/// @return `void`
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::getNode(Node<T>* root, int weight) {
-  if (!weightInbounds(root, weight)) {
-    throw OutOfBoundsException();
+template <class K, class T, class Compare>
+BlockedBST<K, T, Compare>::BlockedBST(const std::pair<K, T>* sorted, size_t count) {
+  this->count = count;
+  this->weights = new K[count];
+  this->values = new T[count];
+  for(size_t i = 0; i < count; i++) {
+    weights[i] = sorted[i].first;
+    values[i] = sorted[i].second;
   }
-  if(root->weight == weight) {
-    return root;
+  size_t total = 0;
+  size_t remaining = count;
+  while(remaining > BLOCK_KEYS) {
+    remaining = (remaining + BLOCK_KEYS - 1) / BLOCK_KEYS;
+    levelCount[levels++] = remaining;
+    total += remaining;
+  }
+  if(!total) {
+    return;
   }
-  if(weight < root->weight) {
-    return this->getNode(root->left, weight);
+  fences = new K[total];
+  const K* below = weights;
+  size_t belowCount = count;
+  size_t offset = 0;
+  for(int level = 0; level < levels; level++) {
+    levelOffset[level] = offset;
+    for(size_t block = 0; block < levelCount[level]; block++) {
+      size_t last = block * BLOCK_KEYS + BLOCK_KEYS;
+      last = (last < belowCount ? last : belowCount) - 1;
+      fences[offset + block] = below[last];
+    }
+    below = fences + offset;
+    belowCount = levelCount[level];
+    offset += levelCount[level];
+  }
+}
+
+template <class K, class T, class Compare>
+BlockedBST<K, T, Compare>::BlockedBST(BlockedBST&& other) {
+  weights = other.weights;
+  values = other.values;
+  fences = other.fences;
+  levels = other.levels;
+  count = other.count;
+  for(int level = 0; level < levels; level++) {
+    levelOffset[level] = other.levelOffset[level];
+    levelCount[level] = other.levelCount[level];
   }
-  return this->getNode(root->right, weight);
+  other.weights = NULL;
+  other.values = NULL;
+  other.fences = NULL;
+  other.levels = 0;
+  other.count = 0;
+}
+
+template <class K, class T, class Compare>
+BlockedBST<K, T, Compare>::~BlockedBST() {
+  delete[] weights;
+  delete[] values;
+  delete[] fences;
 }
 
 /////////////////////////////////////////////////
-/// @param root Current node to traverse from. This is assumed to be the top most node
-/// @param callback Pointer to callback function to pipe integer weights into
-/// as an `int` paramater for verification of balance
-/// @warning Your callback function must be defined/prototyped as
-/// @code
-/// void func(int param)
-/// @endcode
-/// @note An example for using the callback function as verification of proper binary search tree balancing
-/// @code
-///    BST<int> myBST(5,5);
-///
-///    myBST.insert(myBST.getRoot(), 1,1);
-///    myBST.insert(myBST.getRoot(), 2,2);
-///    myBST.insert(myBST.getRoot(), 3,3);
-///    myBST.insert(myBST.getRoot(), 4,4);
-///    myBST.insert(myBST.getRoot(), 6,6);
-///    myBST.insert(myBST.getRoot(), 7,7);
-///
-///    void print(int weight) {
-///    	std::cout << weight << ", ";
-///    }
-///
-///    myBST.traverse(myBST.getRoot(), &print);
-/// @endcode
-/// @endnote
-/// @return `void`
+/// @description Counts the keys in one block that order below
+/// `weight`. The loop has no data-dependent branch — every key in
+/// the block is compared and the results summed — which is exactly
+/// the shape the auto-vectorizer turns into SIMD compares for
+/// primitive `K`
+/// @param keys First key of the block
+/// @param len Number of keys in the block
+/// @param weight Weight being searched for
+/// @return `size_t` Number of keys in the block below `weight`
 /////////////////////////////////////////////////
 
-template <class T>
-void BST<T>::traverse(Node<T>* root, void (*callback)(int)) {
-  if (!root) {
-    return;
+template <class K, class T, class Compare>
+size_t BlockedBST<K, T, Compare>::scanBlock(const K* keys, size_t len, K weight) {
+  size_t below = 0;
+  for(size_t i = 0; i < len; i++) {
+    below += comp(keys[i], weight) ? 1 : 0;
   }
-  traverse(root->left, callback);
-  callback(root->weight);
-  traverse(root->right, callback);
+  return below;
 }
 
 /////////////////////////////////////////////////
-/// @param root Node to begin traversal from and insert the next corresponding weight
-/// @param value Value to insert
-/// @return `Node<T>*` Returns pointer to new node wih corresponding weight and value
+/// @description Descends one block per fence level: the scan of a
+/// block yields the index of the first fence key at or above
+/// `weight`, and because each fence key is the maximum of one block
+/// below, that index is the block to scan next. The final scan of
+/// the sorted leaf block lands on the entry itself
+/// @param weight Weight to look up
+/// @return `T&` Reference to the value stored under `weight`
+/// @throws OutOfBoundsException If the weight is not present
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::insert(Node<T>* root, int weight, T value) {
-  if (!root) {
-    root = new Node<T>(weight, value);
+template <class K, class T, class Compare>
+T& BlockedBST<K, T, Compare>::getBlocked(K weight) {
+  size_t block = 0;
+  for(int level = levels - 1; level >= 0; level--) {
+    const K* keys = fences + levelOffset[level];
+    size_t begin = block * BLOCK_KEYS;
+    size_t end = begin + BLOCK_KEYS;
+    end = end < levelCount[level] ? end : levelCount[level];
+    block = begin + scanBlock(keys + begin, end - begin, weight);
+    if(block == end) {
+      throw OutOfBoundsException();
+    }
   }
-  else if(weight == root->weight) {
-    root->value = value;
+  size_t begin = block * BLOCK_KEYS;
+  size_t end = begin + BLOCK_KEYS;
+  end = end < count ? end : count;
+  size_t index = begin + scanBlock(weights + begin, end - begin, weight);
+  if(index == end || comp(weight, weights[index])) {
+    throw OutOfBoundsException();
   }
-  else if(weight < root->weight) {
-    root->left = insert(root->left, weight, value);
-    root->left->parent = root;
+  return values[index];
+}
+
+/////////////////////////////////////////////////
+/// Index-Packed Small Tree
+/// Mutable AVL tree for bounded keyspaces that stores children as
+/// arena indices instead of 8-byte pointers: with the default
+/// `uint16_t` links and `int` payloads a node is 16 bytes instead
+/// of the pointer tree's 48, so one cache line fill brings in four
+/// nodes and a 64k-entry tree fits in L2. The `Index` knob selects
+/// the link width at compile time — `uint16_t` caps the tree at
+/// 65535 entries, `uint32_t` trades 4 bytes per node for 4 billion.
+/// Nodes live in one contiguous growable array with freed slots
+/// recycled through an index free-list, and the AVL walk is
+/// recursive since the packed nodes carry no parent links
+/// @author Derick Vigne
+/// @copyright MIT License
+/////////////////////////////////////////////////
+
+template <class K, class T = K, class Index = uint16_t, class Compare = std::less<K>>
+class CompactBST {
+private:
+  struct PackedNode {
+    K weight; //!< Weight of the node
+    T value; //!< Value of the node
+    Index left; //!< Arena index of the left child, NIL when absent
+    Index right; //!< Arena index of the right child, NIL when absent
+    int8_t height; //!< AVL height; 127 covers any tree an `Index` can address
+  };
+  static const Index NIL = (Index) -1; ///< Null link; also why the arena holds one slot fewer than `Index` spans
+  PackedNode* nodes = NULL; ///< Contiguous node arena
+  Compare comp; ///< Ordering used for all weight comparisons
+  size_t capacity = 0; ///< Slots currently allocated
+  size_t count = 0; ///< Live entries
+  Index rootIndex = NIL; ///< Arena index of the root
+  Index freeHead = NIL; ///< Head of the freed-slot list, threaded through `left`
+  Index allocSlot(K weight, T value); ///< Hands out a slot, growing the arena by doubling
+  int8_t heightOf(Index node) { return node == NIL ? 0 : nodes[node].height; } ///< Height of a possibly-absent subtree
+  void pullUp(Index node); ///< Recomputes the height at `node`
+  Index rotateLeft(Index node); ///< Left rotation by index
+  Index rotateRight(Index node); ///< Right rotation by index
+  Index rebalanceAt(Index node); ///< Restores the AVL invariant at `node`
+  Index insertAt(Index node, K weight, T value); ///< Recursive descent insert, returns the new subtree root
+  Index removeAt(Index node, K weight); ///< Recursive descent delete, returns the new subtree root
+
+public:
+  CompactBST() {}
+  CompactBST(CompactBST&& other);
+  CompactBST(const CompactBST&) = delete;
+  ~CompactBST() { delete[] nodes; }
+  void insert(K weight, T value); ///< Inserts or overwrites an entry
+  T& getCompact(K weight); ///< Looks a value up by weight
+  void deleteNode(K weight); ///< Removes an entry and rebalances
+  size_t size() { return count; } ///< Number of live entries
+};
+
+template <class K, class T, class Index, class Compare>
+CompactBST<K, T, Index, Compare>::CompactBST(CompactBST&& other) {
+  nodes = other.nodes;
+  capacity = other.capacity;
+  count = other.count;
+  rootIndex = other.rootIndex;
+  freeHead = other.freeHead;
+  other.nodes = NULL;
+  other.capacity = 0;
+  other.count = 0;
+  other.rootIndex = NIL;
+  other.freeHead = NIL;
+}
+
+/////////////////////////////////////////////////
+/// @description Hands out an arena slot, recycling freed slots
+/// first and doubling the arena otherwise. Slots are indices, so
+/// growth relocates the whole arena without disturbing any link
+/// @param weight Weight of the new entry
+/// @param value Value of the new entry
+/// @return `Index` Slot holding the constructed entry
+/// @throws OutOfBoundsException If every index the link type can express is in use
+/////////////////////////////////////////////////
+
+template <class K, class T, class Index, class Compare>
+Index CompactBST<K, T, Index, Compare>::allocSlot(K weight, T value) {
+  Index slot;
+  if(freeHead != NIL) {
+    slot = freeHead;
+    freeHead = nodes[slot].left;
   }
   else {
-    root->right = insert(root->right, weight, value);
-    root->right->parent = root;
+    if(count == (size_t) NIL) {
+      throw OutOfBoundsException();
+    }
+    if(count == capacity) {
+      size_t grown = capacity ? capacity * 2 : 16;
+      if(grown > (size_t) NIL) {
+        grown = (size_t) NIL;
+      }
+      PackedNode* wider = new PackedNode[grown];
+      for(size_t i = 0; i < capacity; i++) {
+        wider[i] = std::move(nodes[i]);
+      }
+      delete[] nodes;
+      nodes = wider;
+      capacity = grown;
+    }
+    slot = (Index) count;
   }
-  return root;
+  nodes[slot].weight = std::move(weight);
+  nodes[slot].value = std::move(value);
+  nodes[slot].left = NIL;
+  nodes[slot].right = NIL;
+  nodes[slot].height = 1;
+  count++;
+  return slot;
+}
+
+template <class K, class T, class Index, class Compare>
+void CompactBST<K, T, Index, Compare>::pullUp(Index node) {
+  int8_t leftHeight = heightOf(nodes[node].left);
+  int8_t rightHeight = heightOf(nodes[node].right);
+  nodes[node].height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+}
+
+template <class K, class T, class Index, class Compare>
+Index CompactBST<K, T, Index, Compare>::rotateLeft(Index node) {
+  Index pivot = nodes[node].right;
+  nodes[node].right = nodes[pivot].left;
+  nodes[pivot].left = node;
+  pullUp(node);
+  pullUp(pivot);
+  return pivot;
+}
+
+template <class K, class T, class Index, class Compare>
+Index CompactBST<K, T, Index, Compare>::rotateRight(Index node) {
+  Index pivot = nodes[node].left;
+  nodes[node].left = nodes[pivot].right;
+  nodes[pivot].right = node;
+  pullUp(node);
+  pullUp(pivot);
+  return pivot;
 }
 
 /////////////////////////////////////////////////
-/// @param root Root node to begin traversal
-/// @param weight Weight of node to remove
-/// @return `void`
+/// @description Index-link version of the AVL repair in
+/// `BST<K, T, Compare>::rebalance`: one single or double rotation
+/// restores the invariant at `node`
+/// @param node Subtree root to repair
+/// @return `Index` Slot now rooting the subtree
 /////////////////////////////////////////////////
 
-template <class T>
-void BST<T>::deleteNode(Node<T> *root, int weight) {
-  if(!weightInbounds(root, weight)) {
-    throw OutOfBoundsException();
-  }
-  if (weight < root->weight) {
-   deleteNode(root->left, weight);
-   return;
+template <class K, class T, class Index, class Compare>
+Index CompactBST<K, T, Index, Compare>::rebalanceAt(Index node) {
+  pullUp(node);
+  int balanceFactor = heightOf(nodes[node].left) - heightOf(nodes[node].right);
+  if(balanceFactor > 1) {
+    if(heightOf(nodes[nodes[node].left].left) < heightOf(nodes[nodes[node].left].right)) {
+      nodes[node].left = rotateLeft(nodes[node].left);
+    }
+    return rotateRight(node);
   }
-  if (weight > root->weight) {
-   deleteNode(root->right, weight);
-   return;
+  if(balanceFactor < -1) {
+    if(heightOf(nodes[nodes[node].right].right) < heightOf(nodes[nodes[node].right].left)) {
+      nodes[node].right = rotateRight(nodes[node].right);
+    }
+    return rotateLeft(node);
   }
-  if (root->left && root->right) {
-   Node<T>* successor = findMinimum(root->right);
-   root->weight = successor->weight;
-   root->value = successor->value;
-   deleteNode(successor, successor->weight);
+  return node;
+}
+
+template <class K, class T, class Index, class Compare>
+Index CompactBST<K, T, Index, Compare>::insertAt(Index node, K weight, T value) {
+  if(node == NIL) {
+    return allocSlot(std::move(weight), std::move(value));
   }
-  else if(root->left) {
-   replace_node_in_parent(root, root->left);
+  // the recursive call can grow and relocate the arena, so the child
+  // link is staged in a local and written back afterwards — assigning
+  // straight into nodes[node] would go through the stale array
+  if(comp(weight, nodes[node].weight)) {
+    Index child = insertAt(nodes[node].left, std::move(weight), std::move(value));
+    nodes[node].left = child;
   }
-  else if(root->right) {
-   replace_node_in_parent(root, root->right);
+  else if(comp(nodes[node].weight, weight)) {
+    Index child = insertAt(nodes[node].right, std::move(weight), std::move(value));
+    nodes[node].right = child;
   }
   else {
-   replace_node_in_parent(root, NULL);
+    nodes[node].value = std::move(value);
+    return node;
   }
+  return rebalanceAt(node);
 }
 
-template <class T>
-void BST<T>::replace_node_in_parent(Node<T> *currentNode, Node<T> *newNode) {
-  if(currentNode->parent) {
-    if(currentNode == currentNode->parent->left) {
-      currentNode->parent->left = newNode;
-    }
-    else {
-      currentNode->parent->right = newNode;
-    }
-    if (newNode) {
-      newNode->parent = currentNode->parent;
+template <class K, class T, class Index, class Compare>
+Index CompactBST<K, T, Index, Compare>::removeAt(Index node, K weight) {
+  if(node == NIL) {
+    throw OutOfBoundsException();
+  }
+  if(comp(weight, nodes[node].weight)) {
+    nodes[node].left = removeAt(nodes[node].left, weight);
+  }
+  else if(comp(nodes[node].weight, weight)) {
+    nodes[node].right = removeAt(nodes[node].right, weight);
+  }
+  else if(nodes[node].left == NIL || nodes[node].right == NIL) {
+    Index child = nodes[node].left != NIL ? nodes[node].left : nodes[node].right;
+    nodes[node].left = freeHead; // thread the slot onto the free-list
+    freeHead = node;
+    count--;
+    return child;
+  }
+  else {
+    // two children: pull the in-order successor's payload into this
+    // slot and delete the successor from the right subtree
+    Index successor = nodes[node].right;
+    while(nodes[successor].left != NIL) {
+      successor = nodes[successor].left;
     }
+    nodes[node].weight = nodes[successor].weight;
+    nodes[node].value = std::move(nodes[successor].value);
+    nodes[node].right = removeAt(nodes[node].right, nodes[node].weight);
   }
+  return rebalanceAt(node);
 }
 
 /////////////////////////////////////////////////
-/// @description Begins traversal at root node to find the smallest, minimum weight
-/// @return `Node<T>*` Returns pointer to minimum node
+/// @description Inserts an entry, overwriting the value if the
+/// weight already exists, keeping the tree AVL-balanced
+/// @param weight Weight of the entry
+/// @param value Value of the entry
+/// @return `void`
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::findMinimum() {
-  Node<T>* currentNode = this->root;
-  while(currentNode->left) {
-    currentNode = currentNode->left;
-  }
-  return currentNode;
+template <class K, class T, class Index, class Compare>
+void CompactBST<K, T, Index, Compare>::insert(K weight, T value) {
+  rootIndex = insertAt(rootIndex, std::move(weight), std::move(value));
 }
 
 /////////////////////////////////////////////////
-/// @description Begins traversal at root node to find the biggest, maximum weight
-/// @return `Node<T>*` Returns pointer to maximum node
+/// @description Iterative descent over the packed arena; every
+/// cache line fetched on the way down carries several nodes
+/// @param weight Weight to look up
+/// @return `T&` Reference to the value stored under `weight`
+/// @throws OutOfBoundsException If the weight is not present
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::findMaximum() {
-  Node<T>* currentNode = this->root;
-  while(currentNode->right) {
-    currentNode = currentNode->right;
+template <class K, class T, class Index, class Compare>
+T& CompactBST<K, T, Index, Compare>::getCompact(K weight) {
+  Index node = rootIndex;
+  while(node != NIL) {
+    if(comp(weight, nodes[node].weight)) {
+      node = nodes[node].left;
+    }
+    else if(comp(nodes[node].weight, weight)) {
+      node = nodes[node].right;
+    }
+    else {
+      return nodes[node].value;
+    }
   }
-  return currentNode;
+  throw OutOfBoundsException();
 }
 
 /////////////////////////////////////////////////
-/// @param root Root node to start traversal from to find minimum
-/// @return `Node<T>*` Returns pointer to minimum node
+/// @description Removes an entry, recycling its arena slot, and
+/// rebalances on the way back up the recursion
+/// @param weight Weight of the entry to remove
+/// @return `void`
+/// @throws OutOfBoundsException If the weight is not present
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::findMinimum(Node<T>* root) {
-  Node<T>* currentNode = root;
-  while(currentNode->left) {
-    currentNode = currentNode->left;
-  }
-  return currentNode;
+template <class K, class T, class Index, class Compare>
+void CompactBST<K, T, Index, Compare>::deleteNode(K weight) {
+  rootIndex = removeAt(rootIndex, weight);
 }
 
 /////////////////////////////////////////////////
-/// @param root Root node to start traversal from to find maximum
-/// @return `Node<T>*` Returns pointer to maximum node
+/// Snapshot File Header
+/// Leads every snapshot written by `BST<K, T, Compare>::save`. The file is
+/// pointer-free: the header is followed by the weights in ascending
+/// order as raw `K` records, then the values as raw `T` records at
+/// `valueOffset`, so the image can be read back or memory-mapped
+/// and served directly with no deserialization
+/// @author Derick Vigne
+/// @copyright MIT License
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::findMaximum(Node<T>* root) {
-  Node<T>* currentNode = root;
-  while(currentNode->right) {
-    currentNode = currentNode->right;
-  }
-  return currentNode;
-}
+struct BSTSnapshotHeader {
+  char magic[8]; //!< Identifies the format, always `"BSTSNAP2"`
+  uint64_t count; //!< Number of entries in the snapshot
+  uint64_t keySize; //!< `sizeof(K)` at save time, checked on load
+  uint64_t valueSize; //!< `sizeof(T)` at save time, checked on load
+  uint64_t valueOffset; //!< Byte offset of the values array in the file
+};
+
+static const char BST_SNAPSHOT_MAGIC[8] = { 'B', 'S', 'T', 'S', 'N', 'A', 'P', '2' }; //!< Expected `BSTSnapshotHeader::magic`
 
 /////////////////////////////////////////////////
-/// @param root Root node to begin traversal
-/// @param minWeight Minimum weight to check
-/// @param maxWeight Maximum weight to check
-/// @return `bool` For balanced or unbalanced
+/// BST class
+/// Autobalancing Binary Search Tree Library
+/// @author Derick Vigne
+/// @copyright MIT License
 /////////////////////////////////////////////////
 
-template <class T>
-bool BST<T>::isBalanced(Node<T>* root, int minWeight, int maxWeight) {
-  if (root  == NULL) {
-    return true;
-  }
-  if (root->weight < minWeight || root->weight > maxWeight) {
-    return false;
-  }
-  return isBalanced(root->left, minWeight, root->weight-1) && isBalanced(root->right, root->weight+1, maxWeight);
-}
+template <class K, class T = K, class Compare = std::less<K>, class Aggregate = BSTNoAggregate<T>>
+class BST {
+private:
+  static const size_t SLAB_NODES = 256; ///< Nodes handed out per slab allocation
+
+  struct FreeNode {
+    FreeNode* next; ///< Link threaded through recycled node slots
+  };
+
+  struct Slab {
+    Slab* next; ///< Next slab in the chain
+    size_t used; ///< Slots handed out from this slab
+    alignas(Node<K, T, Aggregate>) char storage[SLAB_NODES * sizeof(Node<K, T, Aggregate>)]; ///< Raw node storage
+  };
+
+  Node<K, T, Aggregate>* root = NULL; // Root node created when the BST() constructor is executed
+  Compare comp; ///< Ordering applied to weights throughout the tree
+  Node<K, T, Aggregate>* minNode = NULL; ///< Cached global minimum, maintained by insert/deleteNode
+  Node<K, T, Aggregate>* maxNode = NULL; ///< Cached global maximum, maintained by insert/deleteNode
+  Slab* slabs = NULL; ///< Chain of slabs owned by this tree
+  FreeNode* freeList = NULL; ///< Recycled node slots awaiting reuse
+#ifdef BST_THREAD_SAFE
+  mutable std::shared_mutex treeMutex; ///< Reader-writer lock guarding tree-level operations
+#endif
+#ifdef BST_STATS
+  std::atomic<unsigned long long> statComparisons { 0 }; ///< Comparator calls on descent paths
+  std::atomic<unsigned long long> statDescents { 0 }; ///< Descents performed
+  std::atomic<unsigned long long> statDeepestDescent { 0 }; ///< Longest descent observed
+  std::atomic<unsigned long long> statRotations { 0 }; ///< Rotations performed
+  std::atomic<unsigned long long> statAllocations { 0 }; ///< Fresh slab slots handed out
+  std::atomic<unsigned long long> statRecycles { 0 }; ///< Free-list slots handed out
+  static void statMax(std::atomic<unsigned long long>& stat, unsigned long long seen) {
+    unsigned long long current = stat.load(std::memory_order_relaxed);
+    while(seen > current && !stat.compare_exchange_weak(current, seen, std::memory_order_relaxed)) {}
+  } ///< Relaxed running maximum, safe under concurrent readers
+#endif
+  void releaseAll(); ///< `clear()` body, callable while already holding the write lock
+  template <class... Args>
+  Node<K, T, Aggregate>* allocNode(K weight, Args&&... args); ///< Hands out a node from the arena
+  template <class... Args>
+  Node<K, T, Aggregate>* emplaceAt(Node<K, T, Aggregate>* root, K weight, Args&&... args); ///< Descent shared by insert and emplace
+  void freeNode(Node<K, T, Aggregate>* node); ///< Returns a node to the arena free-list
+  void destroySubtree(Node<K, T, Aggregate>* node); ///< Runs node destructors below a given node
+  static int nodeHeight(Node<K, T, Aggregate>* node) { return node ? node->height : 0; } ///< Height of a possibly-NULL subtree
+  static size_t nodeCount(Node<K, T, Aggregate>* node) { return node ? node->size : 0; } ///< Size of a possibly-NULL subtree
+  static void pullUp(Node<K, T, Aggregate>* node); ///< Recomputes a node's height and size from its children
+  Node<K, T, Aggregate>* rotateLeft(Node<K, T, Aggregate>* node); ///< Left rotation, fixing parent links and the tree root
+  Node<K, T, Aggregate>* rotateRight(Node<K, T, Aggregate>* node); ///< Right rotation, fixing parent links and the tree root
+  Node<K, T, Aggregate>* rebalance(Node<K, T, Aggregate>* node); ///< Restores the AVL invariant at a single node
+  void rebalanceUpwards(Node<K, T, Aggregate>* node); ///< Retraces towards the root rebalancing as it goes
+  int recomputeHeights(Node<K, T, Aggregate>* node); ///< Rebuilds height and size fields after a structural rebuild
+  Node<K, T, Aggregate>* buildFromSorted(const std::pair<K, T>* sorted, size_t count, Node<K, T, Aggregate>* parent); ///< Midpoint-splitting bulk builder, collapses duplicate weights into fat nodes
+  Node<K, T, Aggregate>* buildFromRuns(const std::pair<K, T>* sorted, const size_t* runStart, size_t lo, size_t hi, Node<K, T, Aggregate>* parent); ///< Recursive builder over runs of equal weights
+  void pushExtra(Node<K, T, Aggregate>* node, T value); ///< Appends a duplicate value to a node's overflow list
+  bool weightsEqual(const K& a, const K& b) { return !comp(a, b) && !comp(b, a); } ///< Equivalence under the tree's comparator
+  void collectInorder(Node<K, T, Aggregate>* node, std::pair<K, T>* out, size_t& index); ///< Dumps a subtree into an array in weight order
+  void exportSubtree(Node<K, T, Aggregate>* node, K* weights, T* values, size_t capacity, size_t& index); ///< In-order columnar dump into caller buffers
+  static void traverseSubtree(Node<K, T, Aggregate>* node, void (*callback)(K)); ///< Lock-free recursive in-order walk
+  static void collectChunks(Node<K, T, Aggregate>* node, size_t budget, std::vector<std::pair<Node<K, T, Aggregate>*, bool>>& tasks); ///< Splits the tree into balanced traversal tasks
+  template <class Callback>
+  void traverseRangeNode(Node<K, T, Aggregate>* node, K lo, K hi, Callback& callback); ///< Pruned recursive walk for traverseRange
+  void replace_node_in_parent(Node<K, T, Aggregate> *currentNode, Node<K, T, Aggregate> *newNode);
+  bool weightInbounds(K weight); ///< Check if supplised weight is in bounds
+  static const size_t TOMBSTONE_RATIO = 4; ///< `markDeleted` compacts once this fraction of the tree is dead
+  static typename Aggregate::Value liftNode(Node<K, T, Aggregate>* node); ///< Fold of one node's own values, identity when tombstoned
+  typename Aggregate::Value aggregateFrom(Node<K, T, Aggregate>* node, K lo); ///< Fold of a subtree's entries with weight at or above `lo`
+  typename Aggregate::Value aggregateUpTo(Node<K, T, Aggregate>* node, K hi); ///< Fold of a subtree's entries with weight at or below `hi`
+  static bool checkHeights(Node<K, T, Aggregate>* node); ///< Bottom-up local consistency check of the stored height fields
+  size_t auditSeed = 0x9e3779b97f4a7c15ULL; ///< xorshift state steering `auditInvariants` descents
+  size_t deadCount = 0; ///< Tombstones currently in the tree
+  size_t extraEntries = 0; ///< Duplicate values held in fat nodes beyond each node's primary
+  void compactNow(); ///< Rebuilds the tree from its live entries, assumes the write lock is held
+
+public:
+  BST(K weight, T value) { this->root = allocNode(weight, value); this->minNode = this->maxNode = this->root; }
+  BST(const std::pair<K, T>* sorted, size_t count); ///< Bulk-loads a perfectly balanced tree from a sorted array
+  BST(const char* path); ///< Loads a tree from a snapshot file written by save()
+  BST(BST&& other); ///< Steals the other tree's arena and nodes, leaving it empty
+  BST(const BST&) = delete;
+  ~BST() { clear(); }
+  BST<K, T, Compare, Aggregate> snapshot(); ///< Consistent point-in-time copy of the live entries
+  Node<K, T, Aggregate>* search(Node<K, T, Aggregate> *root, T value); ///< Returns pointer to node with value
+  Node<K, T, Aggregate>* getNode(Node<K, T, Aggregate>* root, K weight); ///< Returns pointer to node of given weight
+  void getNodeMany(const K* weights, size_t n, Node<K, T, Aggregate>** out); ///< Resolves a batch of weights with interleaved descents
+  Node<K, T, Aggregate>* insert(Node<K, T, Aggregate>* root, K weight, T value); ///< Inserts a value auto-balancing a tree
+  template <class... Args>
+  Node<K, T, Aggregate>* emplace(K weight, Args&&... args); ///< Constructs a value in place under the given weight
+  Node<K, T, Aggregate>* insertMulti(K weight, T value); ///< Inserts a value, keeping existing values under the same weight
+  std::vector<T> getAll(K weight); ///< Every value stored under a weight, in insertion order
+  size_t valueCount(K weight); ///< Number of values stored under a weight
+  void insertBatch(std::pair<K, T>* batch, size_t count); ///< Sorts a batch and merges it into the tree in one pass
+  void traverse(Node<K, T, Aggregate>* root, void (*callback)(K)); ///< Traverse to node based on weight
+  void parallelTraverse(Node<K, T, Aggregate>* root, void (*callback)(K), unsigned threads); ///< Fans a traversal out over independent subtrees
+  template <class Callback>
+  void traverseRange(K lo, K hi, Callback&& callback); ///< In-order visit of all entries with weight in [lo, hi]
+  void deleteNode(Node<K, T, Aggregate> *currentNode, K weight); ///< Deletes a node and rebalances the tree
+  void markDeleted(K weight); ///< Tombstones a weight in O(depth) with no restructuring
+  void compact(); ///< Drops tombstones and rebuilds the tree densely
+  BST<K, T, Compare, Aggregate> split(K weight); ///< Moves every entry at or above `weight` into a new tree
+  void join(BST&& other); ///< Absorbs a tree whose weight range does not overlap this one
+  Node<K, T, Aggregate>* balance(); ///< Performs a manual balance of the tree
+  Node<K, T, Aggregate>* findMinimum(); ///< Finds the global minimum
+  Node<K, T, Aggregate>* findMaximum(); ///< Finds the global maximum
+  Node<K, T, Aggregate>* findMinimum(Node<K, T, Aggregate>* root); ///< Finds the minimum given a node
+  Node<K, T, Aggregate>* findMaximum(Node<K, T, Aggregate>* root); ///< Finds the maximum given a node
+  Node<K, T, Aggregate>* getRoot(); ///< Returns the root of the BST
+  size_t rank(K weight); ///< Number of entries with weight strictly below a given weight
+  BSTStats getStats(); ///< Snapshots cheap structural and counter-based health metrics
+  typename Aggregate::Value aggregateRange(K lo, K hi); ///< Folds the aggregate policy over all entries with weight in [lo, hi]
+  Node<K, T, Aggregate>* selectKth(size_t k); ///< Returns the k-th smallest entry, zero-indexed
+  size_t size(); ///< Number of distinct weights in O(1), tombstones included
+  int height(); ///< Height of the tree in O(1) from the maintained root field
+  bool isHeightBalanced(); ///< Verifies the AVL balance invariant from the stored height fields
+  bool auditInvariants(double fraction); ///< Spot-checks invariants along a sampled set of random paths
+  bool isBalanced(Node<K, T, Aggregate>* root, K minWeight, K maxWeight); ///< Verify the BST ordering invariant over a range
+  void clear(); ///< Empties the tree and releases the whole arena
+  FrozenBST<K, T, Compare> freeze(); ///< Snapshots the tree into a read-optimized Eytzinger layout
+  BlockedBST<K, T, Compare> freezeBlocked(); ///< Snapshots the tree into a cache-line-dense blocked layout
+  bool save(const char* path); ///< Writes a pointer-free snapshot of the tree to a file
+  size_t exportColumns(K* weights, T* values, size_t capacity); ///< Fills caller-provided weight and value columns in one in-order pass
 
 /////////////////////////////////////////////////
-/// @return `Node<T>*` Returns root
+/// In-Order Iterator
+/// Streams the tree in weight order one entry at a time with no
+/// recursion, no heap allocation and no auxiliary stack: `++` walks
+/// to the in-order successor through the `parent` pointers in O(1)
+/// amortized. Dereferencing yields a `(weight, T&)` pair, so the
+/// tree plugs straight into range-for loops and pull-based
+/// pipelines. Iterators are invalidated by any structural change
 /////////////////////////////////////////////////
 
-template <class T>
-Node<T>* BST<T>::getRoot() {
-  return root;
-}
+  class iterator {
+  private:
+    Node<K, T, Aggregate>* node; ///< Node the iterator currently rests on, NULL at the end
+
+  public:
+    iterator(Node<K, T, Aggregate>* node) : node(node) {}
+    std::pair<const K&, T&> operator*() { return std::pair<const K&, T&>(node->weight, node->value); }
+    Node<K, T, Aggregate>* operator->() { return node; }
+    bool operator==(const iterator& other) const { return node == other.node; }
+    bool operator!=(const iterator& other) const { return node != other.node; }
+
+    iterator& operator++() {
+      do {
+        if(node->right) {
+          node = node->right;
+          while(node->left) {
+            node = node->left;
+          }
+        }
+        else {
+          while(node->parent && node == node->parent->right) {
+            node = node->parent;
+          }
+          node = node->parent;
+        }
+      } while(node && node->dead); // tombstones are invisible to iteration
+      return *this;
+    }
+  };
+
+  iterator begin() { iterator it(minNode); if(minNode && minNode->dead) ++it; return it; } ///< Iterator resting on the smallest live entry
+  iterator end() { return iterator(NULL); } ///< Past-the-end iterator
+};
+
+/////////////////////////////////////////////////
+/// @fn BST<K, T, Compare>::BST(K weight, T value)
+/// @brief Constructor
+///
+/// Used to bootstrap and create
+/// the first root node of the BST
+/// @param weight Sets the weight of the new root node
+/// @param value Sets the value of the new root node
+/// @return `void`
+
+/////////////////////////////////////////////////
+/// @brief Constructor used to create a node
+///
+/// The weight is moved in and the value is constructed in place
+/// from whatever arguments are supplied, so heavy value types pay
+/// no extra copies on the way into the node
+/// @param weight weight of the node
+/// @param args arguments forwarded to the value's constructor
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Aggregate>
+template <class... Args>
+Node<K, T, Aggregate>::Node(K weight, Args&&... args)
+  : weight(std::move(weight)), value(std::forward<Args>(args)...) {
+  aggregate = Aggregate::lift(value);
+}
+
+/////////////////////////////////////////////////
+/// @param sorted Half of the array to build the subtree from
+/// @param count Number of entries in this half
+/// @param parent Parent to hang the subtree from
+/// @return `Node<K, T>*` Root of the built subtree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::buildFromSorted(const std::pair<K, T>* sorted, size_t count, Node<K, T, Aggregate>* parent) {
+  if(!count) {
+    return NULL;
+  }
+  // collapse runs of equal weights so duplicates land in one fat
+  // node and the midpoint split balances by distinct weight
+  size_t* runStart = new size_t[count + 1];
+  size_t runs = 0;
+  for(size_t i = 0; i < count; i++) {
+    if(!i || !weightsEqual(sorted[i].first, sorted[i - 1].first)) {
+      runStart[runs++] = i;
+    }
+  }
+  runStart[runs] = count;
+  Node<K, T, Aggregate>* built = buildFromRuns(sorted, runStart, 0, runs, parent);
+  delete[] runStart;
+  return built;
+}
+
+/////////////////////////////////////////////////
+/// @param sorted Array of pairs sorted ascending by weight
+/// @param runStart Start index of each run of equal weights, with a
+/// sentinel entry holding the total count
+/// @param lo First run of this half
+/// @param hi One past the last run of this half
+/// @param parent Parent to hang the subtree from
+/// @return `Node<K, T>*` Root of the built subtree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::buildFromRuns(const std::pair<K, T>* sorted, const size_t* runStart, size_t lo, size_t hi, Node<K, T, Aggregate>* parent) {
+  if(lo >= hi) {
+    return NULL;
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  Node<K, T, Aggregate>* node = allocNode(sorted[runStart[mid]].first, sorted[runStart[mid]].second);
+  for(size_t i = runStart[mid] + 1; i < runStart[mid + 1]; i++) {
+    pushExtra(node, sorted[i].second);
+    extraEntries++;
+  }
+  node->parent = parent;
+  node->left = buildFromRuns(sorted, runStart, lo, mid, node);
+  node->right = buildFromRuns(sorted, runStart, mid + 1, hi, node);
+  pullUp(node);
+  return node;
+}
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::pushExtra(Node<K, T, Aggregate>* node, T value) {
+  if(!node->extras) {
+    node->extras = new std::vector<T>();
+  }
+  node->extras->push_back(std::move(value));
+}
+
+/////////////////////////////////////////////////
+/// @brief Bulk-load constructor
+///
+/// Builds a perfectly height-balanced tree from an array of
+/// `(weight, value)` pairs already sorted by weight, in O(n) by
+/// recursive midpoint splitting. Nodes are carved out of fresh
+/// arena slabs in order, so the resulting tree is cache-adjacent.
+/// Far faster than repeated `insert` calls when restoring snapshots
+/// @param sorted Array of pairs sorted ascending by weight
+/// @param count Number of pairs in the array
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BST<K, T, Compare, Aggregate>::BST(const std::pair<K, T>* sorted, size_t count) {
+  this->root = buildFromSorted(sorted, count, NULL);
+  this->minNode = this->root ? findMinimum(this->root) : NULL;
+  this->maxNode = this->root ? findMaximum(this->root) : NULL;
+}
+
+/////////////////////////////////////////////////
+/// @brief Move constructor
+///
+/// Takes over the other tree's slabs, free-list and nodes in O(1)
+/// and leaves it empty. Under `BST_THREAD_SAFE` each tree keeps its
+/// own mutex; the source must not be in concurrent use while it is
+/// being moved from
+/// @param other Tree to take over
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BST<K, T, Compare, Aggregate>::BST(BST&& other) {
+  slabs = other.slabs;
+  freeList = other.freeList;
+  root = other.root;
+  minNode = other.minNode;
+  maxNode = other.maxNode;
+  deadCount = other.deadCount;
+  extraEntries = other.extraEntries;
+  comp = other.comp;
+  other.slabs = NULL;
+  other.extraEntries = 0;
+  other.freeList = NULL;
+  other.root = NULL;
+  other.minNode = NULL;
+  other.maxNode = NULL;
+  other.deadCount = 0;
+}
+
+/////////////////////////////////////////////////
+/// @brief Snapshot-loading constructor
+///
+/// Reads a snapshot written by `save()` and bulk-builds a perfectly
+/// balanced tree from it in O(n). The value bytes are copied
+/// verbatim, so `T` must be trivially copyable and match the type
+/// the snapshot was saved with (`sizeof(T)` is checked against the
+/// header). On a missing or malformed file the tree is left empty
+/// @param path File to load the snapshot from
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BST<K, T, Compare, Aggregate>::BST(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if(!file) {
+    return;
+  }
+  if(fseek(file, 0, SEEK_END) != 0) {
+    fclose(file);
+    return;
+  }
+  long fileSize = ftell(file);
+  if(fileSize < (long) sizeof(BSTSnapshotHeader) || fseek(file, 0, SEEK_SET) != 0) {
+    fclose(file);
+    return;
+  }
+  BSTSnapshotHeader header;
+  if(fread(&header, sizeof(header), 1, file) != 1
+     || memcmp(header.magic, BST_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+     || header.keySize != sizeof(K)
+     || header.valueSize != sizeof(T)) {
+    fclose(file);
+    return;
+  }
+  // trust nothing in the header before allocating: a truncated or
+  // tampered file claiming a huge count must leave the tree empty,
+  // not throw bad_alloc out of the constructor
+  if(header.count > ((size_t) fileSize - sizeof(header)) / sizeof(K)
+     || header.valueOffset < sizeof(header) + header.count * sizeof(K)
+     || header.valueOffset > (uint64_t) fileSize
+     || header.count > ((size_t) fileSize - (size_t) header.valueOffset) / sizeof(T)) {
+    fclose(file);
+    return;
+  }
+  size_t count = header.count;
+  K* weights = new K[count];
+  T* values = new T[count];
+  std::pair<K, T>* sorted = NULL;
+  if(fread(weights, sizeof(K), count, file) == count
+     && fseek(file, (long) header.valueOffset, SEEK_SET) == 0
+     && fread(values, sizeof(T), count, file) == count) {
+    sorted = new std::pair<K, T>[count];
+    for(size_t i = 0; i < count; i++) {
+      sorted[i] = std::pair<K, T>(weights[i], values[i]);
+    }
+    this->root = buildFromSorted(sorted, count, NULL);
+    this->minNode = this->root ? findMinimum(this->root) : NULL;
+    this->maxNode = this->root ? findMaximum(this->root) : NULL;
+  }
+  fclose(file);
+  delete[] weights;
+  delete[] values;
+  delete[] sorted;
+}
+
+/////////////////////////////////////////////////
+/// @description Hands out a `Node<K, T>` from the arena, preferring
+/// recycled slots from the free-list before carving a fresh slot
+/// out of the newest slab. Slabs keep nodes contiguous so descents
+/// stay cache-adjacent and no per-insert heap allocation occurs
+/// @param weight Weight of the new node
+/// @param value Value of the new node
+/// @return `Node<K, T>*` Pointer to constructed node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+template <class... Args>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::allocNode(K weight, Args&&... args) {
+  if(freeList) {
+    BST_STAT(statRecycles.fetch_add(1, std::memory_order_relaxed));
+    Node<K, T, Aggregate>* node = reinterpret_cast<Node<K, T, Aggregate>*>(freeList);
+    freeList = freeList->next;
+    return new (node) Node<K, T, Aggregate>(std::move(weight), std::forward<Args>(args)...);
+  }
+  BST_STAT(statAllocations.fetch_add(1, std::memory_order_relaxed));
+  if(!slabs || slabs->used == SLAB_NODES) {
+    Slab* slab = new Slab;
+    slab->next = slabs;
+    slab->used = 0;
+    slabs = slab;
+  }
+  Node<K, T, Aggregate>* node = reinterpret_cast<Node<K, T, Aggregate>*>(slabs->storage) + slabs->used++;
+  return new (node) Node<K, T, Aggregate>(std::move(weight), std::forward<Args>(args)...);
+}
+
+/////////////////////////////////////////////////
+/// @description Destroys a node and threads its slot onto the
+/// free-list so the next `insert` can recycle it
+/// @param node Node to recycle
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::freeNode(Node<K, T, Aggregate>* node) {
+  node->~Node<K, T, Aggregate>();
+  FreeNode* slot = reinterpret_cast<FreeNode*>(node);
+  slot->next = freeList;
+  freeList = slot;
+}
+
+/////////////////////////////////////////////////
+/// @param node Node to begin destroying from
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::destroySubtree(Node<K, T, Aggregate>* node) {
+  if(!node) {
+    return;
+  }
+  destroySubtree(node->left);
+  destroySubtree(node->right);
+  node->~Node<K, T, Aggregate>();
+}
+
+/////////////////////////////////////////////////
+/// @description Empties the tree and hands every slab back to the
+/// system in one sweep instead of freeing node-by-node. The tree
+/// is left empty; the next `insert` re-seeds the root
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::clear() {
+  BST_WRITE_LOCK;
+  releaseAll();
+}
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::releaseAll() {
+  destroySubtree(root);
+  while(slabs) {
+    Slab* next = slabs->next;
+    delete slabs;
+    slabs = next;
+  }
+  freeList = NULL;
+  root = NULL;
+  minNode = NULL;
+  maxNode = NULL;
+  deadCount = 0;
+  extraEntries = 0;
+}
+
+/////////////////////////////////////////////////
+/// @param root Current node to begin searching from
+/// @param value Value to search for
+/// @return `Node<K, T>*` Returns pointer to found node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::search(Node<K, T, Aggregate>* root, T value) {
+  BST_READ_LOCK;
+  if (!this->root || !this->minNode) {
+    return NULL;
+  }
+  if (value < this->minNode->value || value > this->maxNode->value) {
+    return root;
+  }
+  Node<K, T, Aggregate>* currentNode = root;
+  while(currentNode && currentNode->value != value) {
+    currentNode = value < currentNode->value ? currentNode->left : currentNode->right;
+  }
+  return currentNode;
+}
+
+/////////////////////////////////////////////////
+/// @description Two integer comparisons against the cached global
+/// minimum and maximum instead of two root-to-leaf descents
+/// @param weight Weight to check
+/// @return `bool`
+/////////////////////////////////////////////////
+template <class K, class T, class Compare, class Aggregate>
+bool BST<K, T, Compare, Aggregate>::weightInbounds(K weight) {
+  return minNode && !comp(weight, minNode->weight) && !comp(maxNode->weight, weight);
+}
+
+/////////////////////////////////////////////////
+/// @param root Current node to begin traversing from
+/// @param weight Weight of node to fetch
+/// @return `Node<K, T>*` Pointer to node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::getNode(Node<K, T, Aggregate>* root, K weight) {
+  BST_READ_LOCK;
+  if (!weightInbounds(weight)) {
+    throw OutOfBoundsException();
+  }
+  BST_STAT(unsigned long long depth = 0);
+  BST_STAT(statDescents.fetch_add(1, std::memory_order_relaxed));
+  Node<K, T, Aggregate>* currentNode = root;
+  while(currentNode) {
+    BST_PREFETCH_CHILDREN(currentNode);
+    BST_STAT(depth++);
+    if(comp(weight, currentNode->weight)) {
+      BST_STAT(statComparisons.fetch_add(1, std::memory_order_relaxed));
+      currentNode = currentNode->left;
+    }
+    else if(comp(currentNode->weight, weight)) {
+      BST_STAT(statComparisons.fetch_add(2, std::memory_order_relaxed));
+      currentNode = currentNode->right;
+    }
+    else {
+      BST_STAT(statComparisons.fetch_add(2, std::memory_order_relaxed));
+      BST_STAT(statMax(statDeepestDescent, depth));
+      if(currentNode->dead) {
+        break;
+      }
+      return currentNode;
+    }
+  }
+  BST_STAT(statMax(statDeepestDescent, depth));
+  throw OutOfBoundsException();
+}
+
+/////////////////////////////////////////////////
+/// @description Resolves a batch of weights in one call. The batch
+/// is visited in sorted order so neighbouring descents share their
+/// upper path while it is still cached, and eight descents run
+/// interleaved — each pass of the inner loop advances every live
+/// descent one level — so the memory system always has several
+/// independent node fetches in flight instead of one serialized
+/// miss chain per lookup. Weights not present in the tree yield
+/// NULL in `out` rather than throwing, since a partial miss is an
+/// expected outcome for a batch
+/// @param weights Weights to resolve, in any order
+/// @param n Number of weights in the batch
+/// @param out Array of `n` slots filled with the matching nodes, NULL on miss
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::getNodeMany(const K* weights, size_t n, Node<K, T, Aggregate>** out) {
+  BST_READ_LOCK;
+  static const size_t LANES = 8;
+  size_t* order = new size_t[n];
+  for(size_t i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  std::sort(order, order + n,
+    [this, weights](size_t a, size_t b) { return comp(weights[a], weights[b]); });
+  Node<K, T, Aggregate>* laneNode[LANES];
+  size_t laneQuery[LANES];
+  for(size_t lane = 0; lane < LANES; lane++) {
+    laneNode[lane] = NULL;
+  }
+  size_t nextQuery = 0;
+  size_t activeLanes = 0;
+  while(activeLanes || nextQuery < n) {
+    for(size_t lane = 0; lane < LANES; lane++) {
+      if(!laneNode[lane]) {
+        while(nextQuery < n && !laneNode[lane]) {
+          size_t query = order[nextQuery++];
+          out[query] = NULL;
+          if(weightInbounds(weights[query])) {
+            BST_STAT(statDescents.fetch_add(1, std::memory_order_relaxed));
+            laneNode[lane] = this->root;
+            laneQuery[lane] = query;
+            activeLanes++;
+          }
+        }
+        continue;
+      }
+      Node<K, T, Aggregate>* node = laneNode[lane];
+      BST_PREFETCH_CHILDREN(node);
+      K weight = weights[laneQuery[lane]];
+      BST_STAT(statComparisons.fetch_add(2, std::memory_order_relaxed));
+      if(comp(weight, node->weight)) {
+        node = node->left;
+      }
+      else if(comp(node->weight, weight)) {
+        node = node->right;
+      }
+      else {
+        out[laneQuery[lane]] = node->dead ? NULL : node;
+        node = NULL;
+      }
+      laneNode[lane] = node;
+      if(!node) {
+        activeLanes--;
+      }
+    }
+  }
+  delete[] order;
+}
+
+/////////////////////////////////////////////////
+/// @param root Current node to traverse from. This is assumed to be the top most node
+/// @param callback Pointer to callback function to pipe integer weights into
+/// as an `int` paramater for verification of balance
+/// @warning Your callback function must be defined/prototyped as
+/// @code
+/// void func(int param)
+/// @endcode
+/// @note An example for using the callback function as verification of proper binary search tree balancing
+/// @code
+///    BST<int> myBST(5,5);
+///
+///    myBST.insert(myBST.getRoot(), 1,1);
+///    myBST.insert(myBST.getRoot(), 2,2);
+///    myBST.insert(myBST.getRoot(), 3,3);
+///    myBST.insert(myBST.getRoot(), 4,4);
+///    myBST.insert(myBST.getRoot(), 6,6);
+///    myBST.insert(myBST.getRoot(), 7,7);
+///
+///    void print(int weight) {
+///    	std::cout << weight << ", ";
+///    }
+///
+///    myBST.traverse(myBST.getRoot(), &print);
+/// @endcode
+/// @endnote
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::traverse(Node<K, T, Aggregate>* root, void (*callback)(K)) {
+  BST_READ_LOCK;
+  traverseSubtree(root, callback);
+}
+
+/////////////////////////////////////////////////
+/// @param node Node to continue the walk from
+/// @param callback Pointer to callback function receiving each weight
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::traverseSubtree(Node<K, T, Aggregate>* node, void (*callback)(K)) {
+  if (!node) {
+    return;
+  }
+  traverseSubtree(node->left, callback);
+  if(!node->dead) {
+    callback(node->weight);
+  }
+  traverseSubtree(node->right, callback);
+}
+
+/////////////////////////////////////////////////
+/// @description Splits the tree at subtree boundaries into tasks of
+/// at most `budget` nodes each: a task is either a whole subtree or
+/// a single interior node. Tasks come out in weight order, so a
+/// worker draining them sequentially sees an in-order walk
+/// @param node Node to continue splitting from
+/// @param budget Largest subtree handed out as one task
+/// @param tasks Task list being filled; the flag marks whole subtrees
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::collectChunks(Node<K, T, Aggregate>* node, size_t budget, std::vector<std::pair<Node<K, T, Aggregate>*, bool>>& tasks) {
+  if(!node) {
+    return;
+  }
+  if(node->size <= budget) {
+    tasks.push_back(std::pair<Node<K, T, Aggregate>*, bool>(node, true));
+    return;
+  }
+  collectChunks(node->left, budget, tasks);
+  tasks.push_back(std::pair<Node<K, T, Aggregate>*, bool>(node, false));
+  collectChunks(node->right, budget, tasks);
+}
+
+/////////////////////////////////////////////////
+/// @description Fans an in-order traversal out over a thread pool:
+/// the tree is split into independent subtree tasks sized off the
+/// subtree counts, and workers pull tasks until none remain, so the
+/// scan scales across cores for commutative aggregations. Within a
+/// task weights arrive in order, but tasks interleave across
+/// threads; use `traverse` when strict global ordering is required.
+/// The callback is invoked concurrently and must be thread-safe
+/// @param root Node to traverse from. This is assumed to be the top most node
+/// @param callback Pointer to thread-safe callback receiving each weight
+/// @param threads Number of worker threads to spread the scan over
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::parallelTraverse(Node<K, T, Aggregate>* root, void (*callback)(K), unsigned threads) {
+  BST_READ_LOCK;
+  if(!root) {
+    return;
+  }
+  if(threads <= 1) {
+    traverseSubtree(root, callback);
+    return;
+  }
+  size_t budget = root->size / ((size_t) threads * 4) + 1;
+  std::vector<std::pair<Node<K, T, Aggregate>*, bool>> tasks;
+  collectChunks(root, budget, tasks);
+  std::atomic<size_t> nextTask(0);
+  std::vector<std::thread> pool;
+  for(unsigned i = 0; i < threads; i++) {
+    pool.emplace_back([&tasks, &nextTask, callback] {
+      size_t index;
+      while((index = nextTask++) < tasks.size()) {
+        if(tasks[index].second) {
+          traverseSubtree(tasks[index].first, callback);
+        }
+        else if(!tasks[index].first->dead) {
+          callback(tasks[index].first->weight);
+        }
+      }
+    });
+  }
+  for(std::thread& worker : pool) {
+    worker.join();
+  }
+}
+
+/////////////////////////////////////////////////
+/// @param node Node to continue the pruned walk from
+/// @param lo Inclusive lower weight bound
+/// @param hi Inclusive upper weight bound
+/// @param callback Callable invoked with `(K weight, T& value)`
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+template <class Callback>
+void BST<K, T, Compare, Aggregate>::traverseRangeNode(Node<K, T, Aggregate>* node, K lo, K hi, Callback& callback) {
+  if(!node) {
+    return;
+  }
+  if(comp(lo, node->weight)) {
+    traverseRangeNode(node->left, lo, hi, callback);
+  }
+  if(!node->dead && !comp(node->weight, lo) && !comp(hi, node->weight)) {
+    callback(node->weight, node->value);
+  }
+  if(comp(node->weight, hi)) {
+    traverseRangeNode(node->right, lo, hi, callback);
+  }
+}
+
+/////////////////////////////////////////////////
+/// @description Visits every entry with weight in `[lo, hi]` in
+/// weight order, pruning subtrees that cannot intersect the range,
+/// so a k-result scan costs O(log n + k) instead of a full walk.
+/// Templated on the callable so capturing lambdas inline; the
+/// callback receives both the weight and a mutable reference to the
+/// value
+/// @code
+///    myBST.traverseRange(10, 20, [](int weight, int& value) {
+///      std::cout << weight << " = " << value << std::endl;
+///    });
+/// @endcode
+/// @param lo Inclusive lower weight bound
+/// @param hi Inclusive upper weight bound
+/// @param callback Callable invoked with `(K weight, T& value)`
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+template <class Callback>
+void BST<K, T, Compare, Aggregate>::traverseRange(K lo, K hi, Callback&& callback) {
+  BST_READ_LOCK;
+  traverseRangeNode(this->root, lo, hi, callback);
+}
+
+/////////////////////////////////////////////////
+/// @param node Node whose own values to fold
+/// @return `Aggregate::Value` Lift of the node's primary value and
+/// duplicates in insertion order, `identity()` when tombstoned
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+typename Aggregate::Value BST<K, T, Compare, Aggregate>::liftNode(Node<K, T, Aggregate>* node) {
+  if(node->dead) {
+    return Aggregate::identity();
+  }
+  typename Aggregate::Value folded = Aggregate::lift(node->value);
+  if(node->extras) {
+    for(const T& extra : *node->extras) {
+      folded = Aggregate::combine(folded, Aggregate::lift(extra));
+    }
+  }
+  return folded;
+}
+
+/////////////////////////////////////////////////
+/// @param node Node to recompute the height and size of from its children
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::pullUp(Node<K, T, Aggregate>* node) {
+  int leftHeight = nodeHeight(node->left);
+  int rightHeight = nodeHeight(node->right);
+  node->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+  node->size = nodeCount(node->left) + nodeCount(node->right) + 1;
+  // fold in weight order: left subtree, this entry (unless
+  // tombstoned), right subtree
+  typename Aggregate::Value folded = liftNode(node);
+  if(node->left) {
+    folded = Aggregate::combine(node->left->aggregate, folded);
+  }
+  if(node->right) {
+    folded = Aggregate::combine(folded, node->right->aggregate);
+  }
+  node->aggregate = folded;
+}
+
+/////////////////////////////////////////////////
+/// @description Rotates the subtree rooted at `node` to the left,
+/// promoting its right child. All parent links are rewired and the
+/// tree root is reseated if the rotation happened at the top
+/// @param node Node to rotate about
+/// @return `Node<K, T>*` The node now rooting the subtree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::rotateLeft(Node<K, T, Aggregate>* node) {
+  BST_STAT(statRotations.fetch_add(1, std::memory_order_relaxed));
+  Node<K, T, Aggregate>* pivot = node->right;
+  node->right = pivot->left;
+  if(pivot->left) {
+    pivot->left->parent = node;
+  }
+  pivot->parent = node->parent;
+  if(!node->parent) {
+    this->root = pivot;
+  }
+  else if(node == node->parent->left) {
+    node->parent->left = pivot;
+  }
+  else {
+    node->parent->right = pivot;
+  }
+  pivot->left = node;
+  node->parent = pivot;
+  pullUp(node);
+  pullUp(pivot);
+  return pivot;
+}
+
+/////////////////////////////////////////////////
+/// @description Rotates the subtree rooted at `node` to the right,
+/// promoting its left child. All parent links are rewired and the
+/// tree root is reseated if the rotation happened at the top
+/// @param node Node to rotate about
+/// @return `Node<K, T>*` The node now rooting the subtree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::rotateRight(Node<K, T, Aggregate>* node) {
+  BST_STAT(statRotations.fetch_add(1, std::memory_order_relaxed));
+  Node<K, T, Aggregate>* pivot = node->left;
+  node->left = pivot->right;
+  if(pivot->right) {
+    pivot->right->parent = node;
+  }
+  pivot->parent = node->parent;
+  if(!node->parent) {
+    this->root = pivot;
+  }
+  else if(node == node->parent->left) {
+    node->parent->left = pivot;
+  }
+  else {
+    node->parent->right = pivot;
+  }
+  pivot->right = node;
+  node->parent = pivot;
+  pullUp(node);
+  pullUp(pivot);
+  return pivot;
+}
+
+/////////////////////////////////////////////////
+/// @description Checks the AVL balance factor at `node` and applies
+/// the single or double rotation needed to restore the invariant
+/// @param node Node to rebalance
+/// @return `Node<K, T>*` The node now rooting the subtree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::rebalance(Node<K, T, Aggregate>* node) {
+  pullUp(node);
+  int balanceFactor = nodeHeight(node->left) - nodeHeight(node->right);
+  if(balanceFactor > 1) {
+    if(nodeHeight(node->left->left) < nodeHeight(node->left->right)) {
+      rotateLeft(node->left);
+    }
+    return rotateRight(node);
+  }
+  if(balanceFactor < -1) {
+    if(nodeHeight(node->right->right) < nodeHeight(node->right->left)) {
+      rotateRight(node->right);
+    }
+    return rotateLeft(node);
+  }
+  return node;
+}
+
+/////////////////////////////////////////////////
+/// @description Walks the parent chain from `node` to the root,
+/// rebalancing every node on the way. Used after a deletion splices
+/// a node out of the tree
+/// @param node Node to begin retracing from
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::rebalanceUpwards(Node<K, T, Aggregate>* node) {
+  while(node) {
+    node = rebalance(node);
+    node = node->parent;
+  }
+}
+
+/////////////////////////////////////////////////
+/// @param root Node to begin traversal from and insert the next corresponding weight
+/// @param value Value to insert
+/// @return `Node<K, T>*` Returns pointer to new node wih corresponding weight and value
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::insert(Node<K, T, Aggregate>* root, K weight, T value) {
+  BST_WRITE_LOCK;
+  return emplaceAt(root, std::move(weight), std::move(value));
+}
+
+/////////////////////////////////////////////////
+/// @description Constructs a value in place under the given weight,
+/// forwarding the arguments straight into the value's constructor
+/// inside the node: no intermediate `T` is materialized and nothing
+/// is copied. Overwrites the value if the weight already exists,
+/// like `insert`
+/// @param weight Weight to store the value under
+/// @param args Arguments forwarded to the value's constructor
+/// @return `Node<K, T>*` Returns pointer to the new or updated node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+template <class... Args>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::emplace(K weight, Args&&... args) {
+  BST_WRITE_LOCK;
+  return emplaceAt(this->root, std::move(weight), std::forward<Args>(args)...);
+}
+
+/////////////////////////////////////////////////
+/// @param root Node to begin the descent from
+/// @param weight Weight to store the value under
+/// @param args Arguments forwarded to the value's constructor
+/// @return `Node<K, T>*` Returns pointer to the new or updated node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+template <class... Args>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::emplaceAt(Node<K, T, Aggregate>* root, K weight, Args&&... args) {
+  if (!root) {
+    root = allocNode(std::move(weight), std::forward<Args>(args)...);
+    if (!this->root) {
+      this->root = root;
+      this->minNode = this->maxNode = root;
+    }
+    return root;
+  }
+  BST_STAT(unsigned long long depth = 0);
+  BST_STAT(statDescents.fetch_add(1, std::memory_order_relaxed));
+  Node<K, T, Aggregate>* currentNode = root;
+  while(true) {
+    BST_PREFETCH_CHILDREN(currentNode);
+    BST_STAT(depth++);
+    BST_STAT(statComparisons.fetch_add(2, std::memory_order_relaxed));
+    bool goLeft = comp(weight, currentNode->weight);
+    if(!goLeft && !comp(currentNode->weight, weight)) {
+      BST_STAT(statMax(statDeepestDescent, depth));
+      currentNode->value = T(std::forward<Args>(args)...);
+      if(currentNode->dead) {
+        currentNode->dead = false;
+        deadCount--;
+        if(currentNode->extras) {
+          // the tombstone covered every value, so revival starts over
+          // with the new value alone
+          extraEntries -= currentNode->extras->size();
+          currentNode->extras->clear();
+        }
+      }
+      for(Node<K, T, Aggregate>* up = currentNode; up; up = up->parent) {
+        pullUp(up); // overwrites change aggregates without changing shape
+      }
+      return currentNode;
+    }
+    Node<K, T, Aggregate>*& child = goLeft ? currentNode->left : currentNode->right;
+    if(!child) {
+      bool newMin = !minNode || comp(weight, minNode->weight);
+      bool newMax = !maxNode || comp(maxNode->weight, weight);
+      child = allocNode(std::move(weight), std::forward<Args>(args)...);
+      child->parent = currentNode;
+      Node<K, T, Aggregate>* newNode = child;
+      if(newMin) {
+        minNode = newNode;
+      }
+      if(newMax) {
+        maxNode = newNode;
+      }
+      BST_STAT(statMax(statDeepestDescent, depth));
+      rebalanceUpwards(currentNode);
+      return newNode;
+    }
+    currentNode = child;
+  }
+}
+
+/////////////////////////////////////////////////
+/// @description Inserts without displacing what the weight already
+/// holds: duplicate weights collapse into one fat node whose
+/// overflow list keeps every value in insertion order, so a
+/// duplicate-heavy stream costs one node — and one descent — per
+/// distinct weight instead of bloating the tree with artificially
+/// disambiguated keys. `getNode` and iteration still surface the
+/// node's primary (first) value; `getAll` returns all of them and
+/// `deleteNode` peels them back newest-first. The order-statistic
+/// counts behind `rank` and `selectKth` keep counting distinct
+/// weights, while aggregates fold every value. Inserting into a
+/// tombstoned weight revives it with this value as the only
+/// survivor, matching `insert`
+/// @param weight Weight to store the value under
+/// @param value Value to append under the weight
+/// @return `Node<K, T>*` Returns pointer to the node holding the weight
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::insertMulti(K weight, T value) {
+  BST_WRITE_LOCK;
+  Node<K, T, Aggregate>* currentNode = this->root;
+  while(currentNode && !weightsEqual(currentNode->weight, weight)) {
+    BST_PREFETCH_CHILDREN(currentNode);
+    currentNode = comp(weight, currentNode->weight) ? currentNode->left : currentNode->right;
+  }
+  if(!currentNode) {
+    return emplaceAt(this->root, std::move(weight), std::move(value));
+  }
+  if(currentNode->dead) {
+    currentNode->dead = false;
+    deadCount--;
+    if(currentNode->extras) {
+      extraEntries -= currentNode->extras->size();
+      currentNode->extras->clear();
+    }
+    currentNode->value = std::move(value);
+  }
+  else {
+    pushExtra(currentNode, std::move(value));
+    extraEntries++;
+  }
+  for(Node<K, T, Aggregate>* up = currentNode; up; up = up->parent) {
+    pullUp(up);
+  }
+  return currentNode;
+}
+
+/////////////////////////////////////////////////
+/// @description Copies out every value stored under a weight, the
+/// primary first and duplicates after it in insertion order. An
+/// absent or tombstoned weight comes back as an empty vector
+/// rather than a throw, so duplicate-aware callers can probe
+/// without a try block
+/// @param weight Weight to look up
+/// @return `std::vector<T>` Every value under the weight, oldest first
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+std::vector<T> BST<K, T, Compare, Aggregate>::getAll(K weight) {
+  BST_READ_LOCK;
+  std::vector<T> values;
+  Node<K, T, Aggregate>* currentNode = this->root;
+  while(currentNode && !weightsEqual(currentNode->weight, weight)) {
+    BST_PREFETCH_CHILDREN(currentNode);
+    currentNode = comp(weight, currentNode->weight) ? currentNode->left : currentNode->right;
+  }
+  if(currentNode && !currentNode->dead) {
+    values.push_back(currentNode->value);
+    if(currentNode->extras) {
+      values.insert(values.end(), currentNode->extras->begin(), currentNode->extras->end());
+    }
+  }
+  return values;
+}
+
+/////////////////////////////////////////////////
+/// @param weight Weight to look up
+/// @return `size_t` Number of values under the weight, 0 if absent or tombstoned
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+size_t BST<K, T, Compare, Aggregate>::valueCount(K weight) {
+  BST_READ_LOCK;
+  Node<K, T, Aggregate>* currentNode = this->root;
+  while(currentNode && !weightsEqual(currentNode->weight, weight)) {
+    currentNode = comp(weight, currentNode->weight) ? currentNode->left : currentNode->right;
+  }
+  if(!currentNode || currentNode->dead) {
+    return 0;
+  }
+  return 1 + (currentNode->extras ? currentNode->extras->size() : 0);
+}
+
+/////////////////////////////////////////////////
+/// @param node Node to begin collecting from
+/// @param out Array to fill in weight order
+/// @param index Next free slot in the array, advanced as it fills
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::collectInorder(Node<K, T, Aggregate>* node, std::pair<K, T>* out, size_t& index) {
+  if(!node) {
+    return;
+  }
+  collectInorder(node->left, out, index);
+  if(!node->dead) {
+    out[index++] = std::pair<K, T>(node->weight, node->value);
+    if(node->extras) {
+      for(const T& extra : *node->extras) {
+        out[index++] = std::pair<K, T>(node->weight, extra);
+      }
+    }
+  }
+  collectInorder(node->right, out, index);
+}
+
+/////////////////////////////////////////////////
+/// @description Sorts the batch by weight, merges it with the
+/// tree's in-order contents in one linear pass, and rebuilds a
+/// perfectly balanced tree from the merged array. One insert per
+/// record re-descends from the root every time; the merge touches
+/// each entry once, so bursty ingest costs O(n + k) instead of
+/// O(k log n). On duplicate weights the batch value wins, matching
+/// `insert`'s overwrite behavior; within the batch the last
+/// occurrence wins
+/// @param batch Array of `(weight, value)` pairs, reordered in place
+/// @param count Number of pairs in the batch
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::insertBatch(std::pair<K, T>* batch, size_t count) {
+  BST_WRITE_LOCK;
+  if(!count) {
+    return;
+  }
+  std::stable_sort(batch, batch + count,
+    [this](const std::pair<K, T>& a, const std::pair<K, T>& b) { return comp(a.first, b.first); });
+  size_t treeCount = nodeCount(this->root) + extraEntries;
+  std::pair<K, T>* treeDump = new std::pair<K, T>[treeCount];
+  size_t treeIndex = 0;
+  collectInorder(this->root, treeDump, treeIndex);
+  treeCount = treeIndex; // tombstoned entries drop out of the merge
+  std::pair<K, T>* merged = new std::pair<K, T>[treeCount + count];
+  size_t mergedCount = 0;
+  size_t i = 0, j = 0;
+  while(i < treeCount || j < count) {
+    if(j + 1 < count && weightsEqual(batch[j].first, batch[j + 1].first)) {
+      j++; // last occurrence of a duplicate batch weight wins
+      continue;
+    }
+    if(i < treeCount && (j == count || comp(treeDump[i].first, batch[j].first))) {
+      merged[mergedCount++] = treeDump[i++];
+    }
+    else {
+      if(i < treeCount && weightsEqual(treeDump[i].first, batch[j].first)) {
+        i++; // batch value overwrites the tree's entry
+      }
+      merged[mergedCount++] = batch[j++];
+    }
+  }
+  releaseAll();
+  this->root = buildFromSorted(merged, mergedCount, NULL);
+  this->minNode = this->root ? findMinimum(this->root) : NULL;
+  this->maxNode = this->root ? findMaximum(this->root) : NULL;
+  delete[] treeDump;
+  delete[] merged;
+}
+
+/////////////////////////////////////////////////
+/// @description Count-aware removal: a weight holding duplicates
+/// (see `insertMulti`) gives up its newest value first and keeps
+/// its node until the last value goes, so duplicate churn costs a
+/// `pop_back` instead of structural surgery
+/// @param root Root node to begin traversal
+/// @param weight Weight of node to remove
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::deleteNode(Node<K, T, Aggregate> *root, K weight) {
+  BST_WRITE_LOCK;
+  if(!weightInbounds(weight)) {
+    throw OutOfBoundsException();
+  }
+  Node<K, T, Aggregate>* currentNode = root;
+  while(currentNode && !weightsEqual(currentNode->weight, weight)) {
+    BST_PREFETCH_CHILDREN(currentNode);
+    currentNode = comp(weight, currentNode->weight) ? currentNode->left : currentNode->right;
+  }
+  if(!currentNode) {
+    throw OutOfBoundsException();
+  }
+  if(!currentNode->dead && currentNode->extras && !currentNode->extras->empty()) {
+    currentNode->extras->pop_back();
+    extraEntries--;
+    for(Node<K, T, Aggregate>* up = currentNode; up; up = up->parent) {
+      pullUp(up); // the dropped duplicate leaves every enclosing fold
+    }
+    return;
+  }
+  bool droppedMin = currentNode == minNode;
+  bool droppedMax = currentNode == maxNode;
+  Node<K, T, Aggregate>* retraceFrom;
+  if (currentNode->left && currentNode->right) {
+   // continue the same descent to the in-order successor and transplant
+   // it into the deleted node's place; no value is copied and surviving
+   // node addresses stay stable
+   Node<K, T, Aggregate>* successor = currentNode->right;
+   while(successor->left) {
+    successor = successor->left;
+   }
+   if(successor == currentNode->right) {
+    retraceFrom = successor;
+   }
+   else {
+    retraceFrom = successor->parent;
+    replace_node_in_parent(successor, successor->right);
+    successor->right = currentNode->right;
+    successor->right->parent = successor;
+   }
+   successor->left = currentNode->left;
+   successor->left->parent = successor;
+   replace_node_in_parent(currentNode, successor);
+  }
+  else {
+   retraceFrom = currentNode->parent;
+   replace_node_in_parent(currentNode, currentNode->left ? currentNode->left : currentNode->right);
+  }
+  if(currentNode->dead) {
+    deadCount--;
+  }
+  if(currentNode->extras) {
+    extraEntries -= currentNode->extras->size();
+  }
+  freeNode(currentNode);
+  rebalanceUpwards(retraceFrom);
+  if(droppedMin) {
+    minNode = this->root ? findMinimum(this->root) : NULL;
+  }
+  if(droppedMax) {
+    maxNode = this->root ? findMaximum(this->root) : NULL;
+  }
+}
+
+/////////////////////////////////////////////////
+/// @description Lazy delete for churn-heavy workloads: the node is
+/// flagged dead in O(depth) with no structural surgery, so the hot
+/// tree sees two flag flips for a delete-then-reinsert cycle
+/// instead of two rounds of pointer rewiring and rebalancing.
+/// Lookups, traversals, iteration and snapshots all skip
+/// tombstones; the structural counters behind `rank`, `selectKth`
+/// and `getStats` keep counting them until they are compacted away.
+/// Once a quarter of the tree is dead the entries are folded into
+/// one dense rebuild automatically, which invalidates outstanding
+/// node pointers the same way `insertBatch` does. Reinserting a
+/// tombstoned weight revives the node in place
+/// @param weight Weight to tombstone
+/// @return `void`
+/// @throws OutOfBoundsException If the weight is absent or already dead
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::markDeleted(K weight) {
+  BST_WRITE_LOCK;
+  if(!weightInbounds(weight)) {
+    throw OutOfBoundsException();
+  }
+  Node<K, T, Aggregate>* currentNode = this->root;
+  while(currentNode && !weightsEqual(currentNode->weight, weight)) {
+    currentNode = comp(weight, currentNode->weight) ? currentNode->left : currentNode->right;
+  }
+  if(!currentNode || currentNode->dead) {
+    throw OutOfBoundsException();
+  }
+  currentNode->dead = true;
+  deadCount++;
+  for(Node<K, T, Aggregate>* up = currentNode; up; up = up->parent) {
+    pullUp(up); // the dead entry drops out of every enclosing fold
+  }
+  if(deadCount * TOMBSTONE_RATIO >= nodeCount(this->root)) {
+    compactNow();
+  }
+}
+
+/////////////////////////////////////////////////
+/// @description Drops every tombstone by dumping the live entries
+/// in order and bulk-rebuilding a perfectly balanced, cache-adjacent
+/// tree from them — one amortized sequential pass instead of one
+/// structural delete per dead node. All node pointers into the tree
+/// are invalidated
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::compact() {
+  BST_WRITE_LOCK;
+  compactNow();
+}
+
+/////////////////////////////////////////////////
+/// @description Produces a consistent point-in-time copy of the
+/// tree for analytics to run against while ingest continues on the
+/// original. The live entries are dumped in order and bulk-built
+/// into a fresh perfectly balanced, cache-adjacent tree, so the
+/// copy costs one sequential O(n) pass — a different animal from
+/// deep-copying via traverse plus n log n reinserts. Tombstones do
+/// not carry over. True O(1) copy-on-write sharing is off the
+/// table for this structure: nodes carry parent pointers and live
+/// in per-tree slabs, so unrelated trees cannot share subtrees;
+/// under `BST_THREAD_SAFE` writers stall only for the dump pass
+/// @return `BST<K, T, Compare>` Independent copy of the live entries
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BST<K, T, Compare, Aggregate> BST<K, T, Compare, Aggregate>::snapshot() {
+  BST_READ_LOCK;
+  size_t capacity = nodeCount(this->root) + extraEntries;
+  std::pair<K, T>* live = new std::pair<K, T>[capacity];
+  size_t count = 0;
+  collectInorder(this->root, live, count);
+  BST<K, T, Compare, Aggregate> copy(live, count);
+  delete[] live;
+  return copy;
+}
+
+/////////////////////////////////////////////////
+/// @description Splits the tree at `weight` for shard rebalancing:
+/// entries below it stay, entries at or above it come back as a
+/// new tree. Both sides are bulk-rebuilt from one in-order pass, so
+/// the cost is a single sequential O(n) sweep rather than a delete
+/// and reinsert per moved entry. An O(log n) cut is not on offer
+/// here because nodes live in per-tree slab arenas — the moved
+/// subtree's storage cannot change owner — so the rebuild is the
+/// cheapest correct version; it also drops tombstones from both
+/// sides as a side effect. All node pointers are invalidated
+/// @param weight First weight that moves to the returned tree
+/// @return `BST<K, T, Compare>` Tree holding every entry at or above `weight`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BST<K, T, Compare, Aggregate> BST<K, T, Compare, Aggregate>::split(K weight) {
+  BST_WRITE_LOCK;
+  size_t capacity = nodeCount(this->root) + extraEntries;
+  std::pair<K, T>* live = new std::pair<K, T>[capacity];
+  size_t count = 0;
+  collectInorder(this->root, live, count);
+  size_t cut = 0;
+  while(cut < count && comp(live[cut].first, weight)) {
+    cut++;
+  }
+  releaseAll();
+  this->root = buildFromSorted(live, cut, NULL);
+  this->minNode = this->root ? findMinimum(this->root) : NULL;
+  this->maxNode = this->root ? findMaximum(this->root) : NULL;
+  BST<K, T, Compare, Aggregate> high(live + cut, count - cut);
+  delete[] live;
+  return high;
+}
+
+/////////////////////////////////////////////////
+/// @description Absorbs another tree whose weight range does not
+/// overlap this one, in O(log n): one boundary entry is peeled off
+/// the other tree as the pivot, the other tree's slabs and
+/// free-list are adopted wholesale so no node is copied or
+/// reallocated in bulk, and the shorter tree is hung off the taller
+/// one's spine at matching height with the pivot as the hinge —
+/// a handful of pointer writes plus one retrace. The other tree is
+/// left empty. Tombstones on either side survive the join
+/// @param other Tree to absorb; every weight must fall entirely
+/// below or entirely above this tree's range
+/// @return `void`
+/// @throws OutOfBoundsException If the two weight ranges overlap
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::join(BST&& other) {
+  BST_WRITE_LOCK;
+  if(!other.root) {
+    return;
+  }
+  if(!this->root) {
+    releaseAll();
+    this->slabs = other.slabs;
+    this->freeList = other.freeList;
+    this->root = other.root;
+    this->minNode = other.minNode;
+    this->maxNode = other.maxNode;
+    this->deadCount = other.deadCount;
+    this->extraEntries = other.extraEntries;
+    other.slabs = NULL;
+    other.freeList = NULL;
+    other.root = NULL;
+    other.minNode = NULL;
+    other.maxNode = NULL;
+    other.deadCount = 0;
+    other.extraEntries = 0;
+    return;
+  }
+  bool otherAbove = comp(this->maxNode->weight, other.minNode->weight);
+  if(!otherAbove && !comp(other.maxNode->weight, this->minNode->weight)) {
+    throw OutOfBoundsException();
+  }
+  // peel the boundary entry off the other tree while it can still
+  // rebalance itself; it is re-created as the hinge below
+  Node<K, T, Aggregate>* pivotSource = otherAbove ? findMinimum(other.root) : findMaximum(other.root);
+  K pivotWeight = pivotSource->weight;
+  T pivotValue = pivotSource->value;
+  bool pivotDead = pivotSource->dead;
+  // detach the pivot's duplicates first so the count-aware delete
+  // below removes the node instead of peeling values one at a time
+  std::vector<T>* pivotExtras = pivotSource->extras;
+  pivotSource->extras = NULL;
+  if(pivotExtras) {
+    other.extraEntries -= pivotExtras->size();
+  }
+  other.deleteNode(other.root, pivotWeight);
+  // adopt the other tree's arena so its nodes change owner with it
+  if(!this->slabs) {
+    this->slabs = other.slabs;
+  }
+  else {
+    Slab* tail = this->slabs;
+    while(tail->next) {
+      tail = tail->next;
+    }
+    tail->next = other.slabs;
+  }
+  if(!this->freeList) {
+    this->freeList = other.freeList;
+  }
+  else {
+    FreeNode* tail = this->freeList;
+    while(tail->next) {
+      tail = tail->next;
+    }
+    tail->next = other.freeList;
+  }
+  Node<K, T, Aggregate>* left = otherAbove ? this->root : other.root;
+  Node<K, T, Aggregate>* right = otherAbove ? other.root : this->root;
+  this->deadCount += other.deadCount;
+  this->extraEntries += other.extraEntries;
+  other.slabs = NULL;
+  other.freeList = NULL;
+  other.root = NULL;
+  other.minNode = NULL;
+  other.maxNode = NULL;
+  other.deadCount = 0;
+  other.extraEntries = 0;
+  if(!left || !right) {
+    this->root = left ? left : right;
+    this->root->parent = NULL;
+    Node<K, T, Aggregate>* pivotNode = emplaceAt(this->root, std::move(pivotWeight), std::move(pivotValue));
+    pivotNode->extras = pivotExtras;
+    if(pivotExtras) {
+      extraEntries += pivotExtras->size();
+    }
+    if(pivotDead) {
+      pivotNode->dead = true;
+      deadCount++;
+    }
+    if(pivotDead || pivotExtras) {
+      for(Node<K, T, Aggregate>* up = pivotNode; up; up = up->parent) {
+        pullUp(up);
+      }
+    }
+  }
+  else {
+    Node<K, T, Aggregate>* pivotNode = allocNode(std::move(pivotWeight), std::move(pivotValue));
+    pivotNode->dead = pivotDead;
+    pivotNode->extras = pivotExtras;
+    if(pivotExtras) {
+      extraEntries += pivotExtras->size();
+    }
+    if(pivotDead) {
+      deadCount++;
+    }
+    if(nodeHeight(left) >= nodeHeight(right)) {
+      // walk the right spine of the taller side down to the height
+      // of the shorter side and hang the pivot there
+      Node<K, T, Aggregate>* spine = left;
+      while(nodeHeight(spine) > nodeHeight(right) + 1) {
+        spine = spine->right;
+      }
+      Node<K, T, Aggregate>* above = spine->parent;
+      pivotNode->left = spine;
+      spine->parent = pivotNode;
+      pivotNode->right = right;
+      right->parent = pivotNode;
+      if(above) {
+        above->right = pivotNode;
+        pivotNode->parent = above;
+        this->root = left;
+      }
+      else {
+        this->root = pivotNode;
+      }
+    }
+    else {
+      Node<K, T, Aggregate>* spine = right;
+      while(nodeHeight(spine) > nodeHeight(left) + 1) {
+        spine = spine->left;
+      }
+      Node<K, T, Aggregate>* above = spine->parent;
+      pivotNode->right = spine;
+      spine->parent = pivotNode;
+      pivotNode->left = left;
+      left->parent = pivotNode;
+      if(above) {
+        above->left = pivotNode;
+        pivotNode->parent = above;
+        this->root = right;
+      }
+      else {
+        this->root = pivotNode;
+      }
+    }
+    this->root->parent = NULL;
+    rebalanceUpwards(pivotNode);
+  }
+  this->minNode = findMinimum(this->root);
+  this->maxNode = findMaximum(this->root);
+}
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::compactNow() {
+  size_t capacity = nodeCount(this->root) + extraEntries;
+  std::pair<K, T>* live = new std::pair<K, T>[capacity];
+  size_t liveCount = 0;
+  collectInorder(this->root, live, liveCount);
+  releaseAll();
+  this->root = buildFromSorted(live, liveCount, NULL);
+  this->minNode = this->root ? findMinimum(this->root) : NULL;
+  this->maxNode = this->root ? findMaximum(this->root) : NULL;
+  delete[] live;
+}
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::replace_node_in_parent(Node<K, T, Aggregate> *currentNode, Node<K, T, Aggregate> *newNode) {
+  if(currentNode->parent) {
+    if(currentNode == currentNode->parent->left) {
+      currentNode->parent->left = newNode;
+    }
+    else {
+      currentNode->parent->right = newNode;
+    }
+  }
+  else if(currentNode == this->root) {
+    this->root = newNode;
+  }
+  if (newNode) {
+    newNode->parent = currentNode->parent;
+  }
+}
+
+/////////////////////////////////////////////////
+/// @description Begins traversal at root node to find the smallest, minimum weight
+/// @return `Node<K, T>*` Returns pointer to minimum node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::findMinimum() {
+  BST_READ_LOCK;
+  Node<K, T, Aggregate>* currentNode = this->root;
+  if(!currentNode) {
+    return NULL;
+  }
+  while(currentNode->left) {
+    currentNode = currentNode->left;
+  }
+  return currentNode;
+}
+
+/////////////////////////////////////////////////
+/// @description Begins traversal at root node to find the biggest, maximum weight
+/// @return `Node<K, T>*` Returns pointer to maximum node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::findMaximum() {
+  BST_READ_LOCK;
+  Node<K, T, Aggregate>* currentNode = this->root;
+  if(!currentNode) {
+    return NULL;
+  }
+  while(currentNode->right) {
+    currentNode = currentNode->right;
+  }
+  return currentNode;
+}
+
+/////////////////////////////////////////////////
+/// @param root Root node to start traversal from to find minimum
+/// @return `Node<K, T>*` Returns pointer to minimum node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::findMinimum(Node<K, T, Aggregate>* root) {
+  Node<K, T, Aggregate>* currentNode = root;
+  while(currentNode->left) {
+    currentNode = currentNode->left;
+  }
+  return currentNode;
+}
+
+/////////////////////////////////////////////////
+/// @param root Root node to start traversal from to find maximum
+/// @return `Node<K, T>*` Returns pointer to maximum node
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::findMaximum(Node<K, T, Aggregate>* root) {
+  Node<K, T, Aggregate>* currentNode = root;
+  while(currentNode->right) {
+    currentNode = currentNode->right;
+  }
+  return currentNode;
+}
+
+/////////////////////////////////////////////////
+/// @description Verifies the BST ordering invariant over a weight
+/// range in O(n); despite the name it says nothing about balance —
+/// see `isHeightBalanced` for that and `auditInvariants` for a
+/// sampled check cheap enough to run continuously
+/// @param root Root node to begin traversal
+/// @param minWeight Minimum weight to check
+/// @param maxWeight Maximum weight to check
+/// @return `bool` For balanced or unbalanced
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+bool BST<K, T, Compare, Aggregate>::isBalanced(Node<K, T, Aggregate>* root, K minWeight, K maxWeight) {
+  BST_READ_LOCK;
+  if (root  == NULL) {
+    return true;
+  }
+  if (comp(root->weight, minWeight) || comp(maxWeight, root->weight)) {
+    return false;
+  }
+  if (root->left && !comp(root->left->weight, root->weight)) {
+    return false;
+  }
+  if (root->right && !comp(root->weight, root->right->weight)) {
+    return false;
+  }
+  return isBalanced(root->left, minWeight, root->weight) && isBalanced(root->right, root->weight, maxWeight);
+}
+
+/////////////////////////////////////////////////
+/// @description Number of distinct weights in the tree, read
+/// straight off the root's maintained subtree count in O(1).
+/// Tombstoned weights are included until they are compacted away,
+/// matching `rank`, `selectKth` and `getStats`; duplicate values
+/// under one weight count once — `valueCount` counts them
+/// @return `size_t` Number of nodes in the tree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+size_t BST<K, T, Compare, Aggregate>::size() {
+  BST_READ_LOCK;
+  return nodeCount(this->root);
+}
+
+/////////////////////////////////////////////////
+/// @return `int` Height of the tree in O(1), 0 when empty
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+int BST<K, T, Compare, Aggregate>::height() {
+  BST_READ_LOCK;
+  return nodeHeight(this->root);
+}
+
+/////////////////////////////////////////////////
+/// @description True balance check, unlike `isBalanced` which
+/// verifies ordering: every node's stored height must equal one
+/// plus the taller stored child height and the two children may
+/// differ by at most one. Local consistency at every node implies
+/// the global AVL invariant by induction, so nothing is
+/// recomputed — one O(n) pointer walk over fields the rebalancing
+/// machinery already maintains
+/// @return `bool` Whether the AVL height invariant holds everywhere
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+bool BST<K, T, Compare, Aggregate>::isHeightBalanced() {
+  BST_READ_LOCK;
+  return checkHeights(this->root);
+}
+
+template <class K, class T, class Compare, class Aggregate>
+bool BST<K, T, Compare, Aggregate>::checkHeights(Node<K, T, Aggregate>* node) {
+  if(!node) {
+    return true;
+  }
+  int left = nodeHeight(node->left);
+  int right = nodeHeight(node->right);
+  int taller = left > right ? left : right;
+  int gap = left > right ? left - right : right - left;
+  if(node->height != taller + 1 || gap > 1) {
+    return false;
+  }
+  return checkHeights(node->left) && checkHeights(node->right);
+}
+
+/////////////////////////////////////////////////
+/// @description Cheap continuous validation for production health
+/// checks: walks a random sample of root-to-leaf paths and verifies
+/// ordering, parent back-pointers and the stored height and size
+/// fields at every node touched, instead of an all-or-nothing O(n)
+/// scan. The number of paths is `fraction` of the node count
+/// (at least one), so `auditInvariants(0.01)` costs about
+/// n/100 * log n pointer reads and can run every scrape interval.
+/// A corrupt region is caught probabilistically; run `fraction = 1`
+/// or `isHeightBalanced` plus `isBalanced` for certainty
+/// @param fraction Share of the node count to spend on sampled paths, clamped to [0, 1]
+/// @return `bool` Whether every sampled path held all invariants
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+bool BST<K, T, Compare, Aggregate>::auditInvariants(double fraction) {
+  BST_READ_LOCK;
+  if(!this->root) {
+    return true;
+  }
+  if(this->root->parent) {
+    return false;
+  }
+  if(fraction < 0) {
+    fraction = 0;
+  }
+  if(fraction > 1) {
+    fraction = 1;
+  }
+  size_t paths = (size_t)(fraction * (double) nodeCount(this->root)) + 1;
+  for(size_t p = 0; p < paths; p++) {
+    Node<K, T, Aggregate>* currentNode = this->root;
+    while(currentNode) {
+      Node<K, T, Aggregate>* left = currentNode->left;
+      Node<K, T, Aggregate>* right = currentNode->right;
+      if(left && (left->parent != currentNode || !comp(left->weight, currentNode->weight))) {
+        return false;
+      }
+      if(right && (right->parent != currentNode || !comp(currentNode->weight, right->weight))) {
+        return false;
+      }
+      int taller = nodeHeight(left) > nodeHeight(right) ? nodeHeight(left) : nodeHeight(right);
+      int gap = nodeHeight(left) - nodeHeight(right);
+      if(currentNode->height != taller + 1 || gap > 1 || gap < -1) {
+        return false;
+      }
+      if(currentNode->size != nodeCount(left) + nodeCount(right) + 1) {
+        return false;
+      }
+      // xorshift64 steers the descent so repeated audits cover
+      // different paths
+      auditSeed ^= auditSeed << 13;
+      auditSeed ^= auditSeed >> 7;
+      auditSeed ^= auditSeed << 17;
+      currentNode = (auditSeed & 1) ? left : right;
+      if(!currentNode) {
+        currentNode = (auditSeed & 1) ? right : left;
+      }
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// @param node Node to begin recomputing heights from
+/// @return `int` Height of the subtree rooted at `node`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+int BST<K, T, Compare, Aggregate>::recomputeHeights(Node<K, T, Aggregate>* node) {
+  if(!node) {
+    return 0;
+  }
+  recomputeHeights(node->left);
+  recomputeHeights(node->right);
+  pullUp(node);
+  return node->height;
+}
+
+/////////////////////////////////////////////////
+/// @description Rebuilds the whole tree into a perfectly balanced
+/// shape using the Day-Stout-Warren algorithm: the tree is first
+/// rotated into a right-spine vine, then compressed with log n
+/// passes of left rotations. Runs in O(n) with no extra memory.
+/// `insert` and `deleteNode` keep the tree AVL-balanced on their
+/// own, so this is only needed to compact a tree to minimum height
+/// @return `Node<K, T>*` Returns the new root
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::balance() {
+  BST_WRITE_LOCK;
+  if(!this->root) {
+    return NULL;
+  }
+  size_t count = 0;
+  Node<K, T, Aggregate>* node = this->root;
+  while(node) {
+    if(node->left) {
+      node = rotateRight(node);
+    }
+    else {
+      count++;
+      node = node->right;
+    }
+  }
+  size_t m = 1;
+  while(m * 2 + 1 <= count) {
+    m = m * 2 + 1;
+  }
+  size_t rotations = count - m;
+  while(true) {
+    Node<K, T, Aggregate>* target = this->root;
+    for(size_t i = 0; i < rotations; i++) {
+      target = rotateLeft(target)->right;
+    }
+    if(m <= 1) {
+      break;
+    }
+    m /= 2;
+    rotations = m;
+  }
+  recomputeHeights(this->root);
+  return this->root;
+}
+
+/////////////////////////////////////////////////
+/// @description Snapshots the live tree into a `FrozenBST<K, T, Compare>`: the
+/// contents are collected in weight order and laid out in Eytzinger
+/// (BFS) order in two contiguous arrays. The snapshot is immutable
+/// and independent of the live tree, and `getFrozen` on it is
+/// several times faster than `getNode` for read-heavy phases
+/// @return `FrozenBST<K, T, Compare>` Read-only snapshot of the tree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+FrozenBST<K, T, Compare> BST<K, T, Compare, Aggregate>::freeze() {
+  BST_READ_LOCK;
+  size_t count = nodeCount(this->root) + extraEntries;
+  std::pair<K, T>* sorted = new std::pair<K, T>[count];
+  size_t index = 0;
+  collectInorder(this->root, sorted, index);
+  FrozenBST<K, T, Compare> frozen(sorted, index);
+  delete[] sorted;
+  return frozen;
+}
+
+/////////////////////////////////////////////////
+/// @description Snapshots the live tree into a `BlockedBST<K, T, Compare>`:
+/// keys land sorted in blocks of sixteen with fence levels sampled
+/// above, so lookups against the snapshot touch a handful of fully
+/// useful cache lines instead of one pointer-laden line per tree
+/// level. The live tree is untouched and later mutations to it do
+/// not show through
+/// @return `BlockedBST<K, T, Compare>` Read-only snapshot of the tree
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BlockedBST<K, T, Compare> BST<K, T, Compare, Aggregate>::freezeBlocked() {
+  BST_READ_LOCK;
+  size_t count = nodeCount(this->root) + extraEntries;
+  std::pair<K, T>* sorted = new std::pair<K, T>[count];
+  size_t index = 0;
+  collectInorder(this->root, sorted, index);
+  BlockedBST<K, T, Compare> blocked(sorted, index);
+  delete[] sorted;
+  return blocked;
+}
+
+/////////////////////////////////////////////////
+/// @description Writes the tree to a pointer-free snapshot file:
+/// a `BSTSnapshotHeader`, the weights in ascending order as
+/// raw `K` records, then the raw value records. The image can be loaded
+/// back with the `BST(const char* path)` constructor or served
+/// in place by `MappedBST<T>` with zero deserialization. Values
+/// are written verbatim, so `T` must be trivially copyable
+/// @param path File to write the snapshot to
+/// @return `bool` True if the snapshot was fully written
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+bool BST<K, T, Compare, Aggregate>::save(const char* path) {
+  BST_READ_LOCK;
+  size_t count = nodeCount(this->root) + extraEntries;
+  std::pair<K, T>* sorted = new std::pair<K, T>[count];
+  size_t index = 0;
+  collectInorder(this->root, sorted, index);
+  count = index; // tombstoned entries were skipped
+  FILE* file = fopen(path, "wb");
+  if(!file) {
+    delete[] sorted;
+    return false;
+  }
+  BSTSnapshotHeader header;
+  memcpy(header.magic, BST_SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.count = count;
+  header.keySize = sizeof(K);
+  header.valueSize = sizeof(T);
+  size_t weightsEnd = sizeof(header) + count * sizeof(K);
+  header.valueOffset = (weightsEnd + 15) & ~(uint64_t) 15; // keep the values array aligned when mapped
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  for(size_t i = 0; ok && i < count; i++) {
+    ok = fwrite(&sorted[i].first, sizeof(K), 1, file) == 1;
+  }
+  char padding[16] = { 0 };
+  if(ok && header.valueOffset > weightsEnd) {
+    ok = fwrite(padding, header.valueOffset - weightsEnd, 1, file) == 1;
+  }
+  for(size_t i = 0; ok && i < count; i++) {
+    ok = fwrite(&sorted[i].second, sizeof(T), 1, file) == 1;
+  }
+  ok = fclose(file) == 0 && ok;
+  delete[] sorted;
+  return ok;
+}
+
+/////////////////////////////////////////////////
+/// @description Columnar export for analytics and network
+/// shipping: fills caller-provided weight and value arrays in one
+/// in-order walk, writing each entry exactly once with no
+/// intermediate allocation, so the buffers can live in pinned or
+/// shared memory and go straight onto the wire. Duplicate values
+/// under one weight come out as consecutive entries with the
+/// weight repeated, in insertion order; tombstoned weights are
+/// skipped. The columns match the on-disk layout written by
+/// `save`, minus the header
+/// @param weights Caller-provided array for the weight column
+/// @param values Caller-provided array for the value column
+/// @param capacity Number of entries each array can hold
+/// @return `size_t` Number of entries written to both columns
+/// @throws OutOfBoundsException If the buffers fill before the
+/// walk finishes; the columns' contents are unspecified then
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+size_t BST<K, T, Compare, Aggregate>::exportColumns(K* weights, T* values, size_t capacity) {
+  BST_READ_LOCK;
+  size_t index = 0;
+  exportSubtree(this->root, weights, values, capacity, index);
+  return index;
+}
+
+template <class K, class T, class Compare, class Aggregate>
+void BST<K, T, Compare, Aggregate>::exportSubtree(Node<K, T, Aggregate>* node, K* weights, T* values, size_t capacity, size_t& index) {
+  if(!node) {
+    return;
+  }
+  exportSubtree(node->left, weights, values, capacity, index);
+  if(!node->dead) {
+    size_t needed = 1 + (node->extras ? node->extras->size() : 0);
+    if(capacity - index < needed) {
+      throw OutOfBoundsException();
+    }
+    weights[index] = node->weight;
+    values[index] = node->value;
+    index++;
+    if(node->extras) {
+      for(const T& extra : *node->extras) {
+        weights[index] = node->weight;
+        values[index] = extra;
+        index++;
+      }
+    }
+  }
+  exportSubtree(node->right, weights, values, capacity, index);
+}
+
+/////////////////////////////////////////////////
+/// @return `Node<K, T>*` Returns root
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::getRoot() {
+  BST_READ_LOCK;
+  return root;
+}
+
+/////////////////////////////////////////////////
+/// @description Counts the entries with weight strictly below the
+/// given weight in O(log n) using the subtree size counts, instead
+/// of an O(n) traversal
+/// @param weight Weight to rank
+/// @return `size_t` Number of entries below `weight`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+size_t BST<K, T, Compare, Aggregate>::rank(K weight) {
+  BST_READ_LOCK;
+  size_t below = 0;
+  Node<K, T, Aggregate>* currentNode = this->root;
+  while(currentNode) {
+    if(!comp(currentNode->weight, weight)) {
+      currentNode = currentNode->left;
+    }
+    else {
+      below += nodeCount(currentNode->left) + 1;
+      currentNode = currentNode->right;
+    }
+  }
+  return below;
+}
+
+/////////////////////////////////////////////////
+/// @description Finds the k-th smallest entry in O(log n) by
+/// steering the descent with the subtree size counts. Zero-indexed,
+/// so `selectKth(rank(w))` returns the node holding weight `w`
+/// @param k Zero-based rank of the entry to fetch
+/// @return `Node<K, T>*` Pointer to the k-th smallest node
+/// @throws OutOfBoundsException If `k` is at or beyond the tree size
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+Node<K, T, Aggregate>* BST<K, T, Compare, Aggregate>::selectKth(size_t k) {
+  BST_READ_LOCK;
+  Node<K, T, Aggregate>* currentNode = this->root;
+  while(currentNode) {
+    size_t leftCount = nodeCount(currentNode->left);
+    if(k < leftCount) {
+      currentNode = currentNode->left;
+    }
+    else if(k == leftCount) {
+      return currentNode;
+    }
+    else {
+      k -= leftCount + 1;
+      currentNode = currentNode->right;
+    }
+  }
+  throw OutOfBoundsException();
+}
+
+/////////////////////////////////////////////////
+/// @description Folds the aggregate policy over every live entry
+/// with weight in `[lo, hi]` in O(log n): the descent to the split
+/// node plus one boundary walk down each side combine whole-subtree
+/// summaries maintained by `pullUp`, never touching the entries in
+/// between. With the default `BSTNoAggregate` policy this compiles
+/// to nothing useful — instantiate the tree with `BSTSumAggregate`,
+/// `BSTMinAggregate`, `BSTMaxAggregate` or a custom monoid.
+/// Tombstoned entries are excluded from every fold
+/// @param lo Inclusive lower weight bound
+/// @param hi Inclusive upper weight bound
+/// @return `Aggregate::Value` Fold over the range, `identity()` when empty
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+typename Aggregate::Value BST<K, T, Compare, Aggregate>::aggregateRange(K lo, K hi) {
+  BST_READ_LOCK;
+  Node<K, T, Aggregate>* node = this->root;
+  while(node && (comp(node->weight, lo) || comp(hi, node->weight))) {
+    node = comp(node->weight, lo) ? node->right : node->left;
+  }
+  if(!node) {
+    return Aggregate::identity();
+  }
+  // node is the split point: everything at or above lo in its left
+  // subtree, everything at or below hi in its right subtree
+  typename Aggregate::Value folded = liftNode(node);
+  folded = Aggregate::combine(aggregateFrom(node->left, lo), folded);
+  folded = Aggregate::combine(folded, aggregateUpTo(node->right, hi));
+  return folded;
+}
+
+/////////////////////////////////////////////////
+/// @param node Subtree to fold over
+/// @param lo Inclusive lower weight bound
+/// @return `Aggregate::Value` Fold of the subtree's entries at or above `lo`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+typename Aggregate::Value BST<K, T, Compare, Aggregate>::aggregateFrom(Node<K, T, Aggregate>* node, K lo) {
+  if(!node) {
+    return Aggregate::identity();
+  }
+  if(comp(node->weight, lo)) {
+    return aggregateFrom(node->right, lo);
+  }
+  typename Aggregate::Value folded = liftNode(node);
+  folded = Aggregate::combine(aggregateFrom(node->left, lo), folded);
+  if(node->right) {
+    folded = Aggregate::combine(folded, node->right->aggregate);
+  }
+  return folded;
+}
+
+/////////////////////////////////////////////////
+/// @param node Subtree to fold over
+/// @param hi Inclusive upper weight bound
+/// @return `Aggregate::Value` Fold of the subtree's entries at or below `hi`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+typename Aggregate::Value BST<K, T, Compare, Aggregate>::aggregateUpTo(Node<K, T, Aggregate>* node, K hi) {
+  if(!node) {
+    return Aggregate::identity();
+  }
+  if(comp(hi, node->weight)) {
+    return aggregateUpTo(node->left, hi);
+  }
+  typename Aggregate::Value folded = liftNode(node);
+  if(node->left) {
+    folded = Aggregate::combine(node->left->aggregate, folded);
+  }
+  folded = Aggregate::combine(folded, aggregateUpTo(node->right, hi));
+  return folded;
+}
+
+/////////////////////////////////////////////////
+/// @description Snapshots the health of the tree. Node count,
+/// height and slab count come straight from maintained state and
+/// cost O(slabs); the descent, comparison, rotation and allocator
+/// counters are cumulative since construction and only tick when
+/// the header is compiled with `BST_STATS`. The counters are
+/// relaxed atomics: concurrent readers under `BST_THREAD_SAFE`
+/// tick them race-free, though one snapshot is not a single
+/// consistent instant — they are telemetry, not ground truth
+/// @return `BSTStats` Copy of the current metrics
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BSTStats BST<K, T, Compare, Aggregate>::getStats() {
+  BST_READ_LOCK;
+  BSTStats stats = {};
+  stats.nodeCount = nodeCount(this->root);
+  stats.height = nodeHeight(this->root);
+  for(Slab* slab = slabs; slab; slab = slab->next) {
+    stats.slabCount++;
+  }
+#ifdef BST_STATS
+  stats.comparisons = statComparisons.load(std::memory_order_relaxed);
+  stats.descents = statDescents.load(std::memory_order_relaxed);
+  stats.deepestDescent = statDeepestDescent.load(std::memory_order_relaxed);
+  stats.rotations = statRotations.load(std::memory_order_relaxed);
+  stats.allocations = statAllocations.load(std::memory_order_relaxed);
+  stats.recycles = statRecycles.load(std::memory_order_relaxed);
+#endif
+  return stats;
+}
+
+/////////////////////////////////////////////////
+/// Streaming Ingest Front End
+/// Decouples producers from the tree's write path: `enqueue` claims
+/// a slot in a bounded lock-free MPSC ring (per-slot sequence
+/// numbers, one CAS per record) and returns in nanoseconds
+/// regardless of tree state, while one dedicated writer thread
+/// drains the ring and applies the records. Small drains go through
+/// per-record `insert`; when the writer falls far behind, a drain
+/// is handed to `insertBatch` so the catch-up costs one merge
+/// rebuild instead of thousands of descents. `flushAndWait` gives a
+/// caller read-your-writes. Compile the tree with
+/// `BST_THREAD_SAFE` if anything reads it while ingest is running;
+/// producers must stop enqueuing before the front end is destroyed
+/// @author Derick Vigne
+/// @copyright MIT License
+/////////////////////////////////////////////////
+
+template <class K, class T = K, class Compare = std::less<K>, class Aggregate = BSTNoAggregate<T>>
+class BSTIngest {
+private:
+  struct Slot {
+    std::atomic<size_t> sequence; //!< Ticket coordinating producers and the writer, Vyukov-style
+    K weight; //!< Enqueued weight
+    T value; //!< Enqueued value
+  };
+  static const size_t BULK_THRESHOLD = 1024; ///< Drains at least this large go through `insertBatch`
+  BST<K, T, Compare, Aggregate>& tree; ///< Tree the writer thread feeds
+  Slot* ring; ///< Bounded ring, capacity rounded up to a power of two
+  std::pair<K, T>* batch; ///< Writer-side staging buffer, one ring's worth
+  size_t mask; ///< Capacity minus one, for cheap slot indexing
+  std::atomic<size_t> enqueuePos; ///< Next ticket producers claim
+  size_t dequeuePos = 0; ///< Next ticket the writer consumes; writer-thread only
+  std::atomic<size_t> applied; ///< Records applied to the tree, visible to `flushAndWait`
+  std::atomic<bool> running; ///< Cleared by the destructor to stop the writer
+  std::thread writer; ///< Dedicated tree-writer thread
+  void drain(); ///< Writer loop: pull records off the ring and apply them
+
+public:
+  BSTIngest(BST<K, T, Compare, Aggregate>& tree, size_t capacity = 4096);
+  BSTIngest(const BSTIngest&) = delete;
+  ~BSTIngest();
+  void enqueue(K weight, T value); ///< Hands a record to the writer thread, blocking only when the ring is full
+  void flushAndWait(); ///< Returns once everything enqueued before the call is in the tree
+};
+
+/////////////////////////////////////////////////
+/// @param tree Tree the writer thread feeds; must outlive the front end
+/// @param capacity Ring size in records, rounded up to a power of two
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BSTIngest<K, T, Compare, Aggregate>::BSTIngest(BST<K, T, Compare, Aggregate>& tree, size_t capacity)
+  : tree(tree), enqueuePos(0), applied(0), running(true) {
+  size_t rounded = 1;
+  while(rounded < capacity) {
+    rounded *= 2;
+  }
+  mask = rounded - 1;
+  ring = new Slot[rounded];
+  batch = new std::pair<K, T>[rounded];
+  for(size_t i = 0; i < rounded; i++) {
+    ring[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  writer = std::thread([this] { drain(); });
+}
+
+/////////////////////////////////////////////////
+/// @description Stops the writer after it has drained everything
+/// still in the ring. Producers must already have stopped
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+BSTIngest<K, T, Compare, Aggregate>::~BSTIngest() {
+  running.store(false, std::memory_order_release);
+  writer.join();
+  delete[] ring;
+  delete[] batch;
+}
+
+/////////////////////////////////////////////////
+/// @description Claims a ticket with one CAS, fills the slot and
+/// publishes it by bumping the slot's sequence number. Safe to call
+/// from any number of producer threads concurrently; spins only
+/// when the ring is full, i.e. the writer is a whole ring behind
+/// @param weight Weight of the record
+/// @param value Value of the record
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BSTIngest<K, T, Compare, Aggregate>::enqueue(K weight, T value) {
+  size_t pos = enqueuePos.load(std::memory_order_relaxed);
+  for(;;) {
+    Slot& slot = ring[pos & mask];
+    intptr_t lag = (intptr_t) slot.sequence.load(std::memory_order_acquire) - (intptr_t) pos;
+    if(lag == 0) {
+      if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    else if(lag < 0) {
+      std::this_thread::yield(); // ring full: wait for the writer
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+    else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  Slot& slot = ring[pos & mask];
+  slot.weight = std::move(weight);
+  slot.value = std::move(value);
+  slot.sequence.store(pos + 1, std::memory_order_release);
+}
+
+/////////////////////////////////////////////////
+/// @description Barrier for read-your-writes: snapshots the ticket
+/// counter and returns once the writer has applied at least that
+/// many records to the tree
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BSTIngest<K, T, Compare, Aggregate>::flushAndWait() {
+  size_t target = enqueuePos.load(std::memory_order_acquire);
+  while(applied.load(std::memory_order_acquire) < target) {
+    std::this_thread::yield();
+  }
+}
+
+/////////////////////////////////////////////////
+/// @description Writer loop. Each pass pulls every published
+/// record off the ring into the staging buffer, then applies them:
+/// per-record `insert` for ordinary drains, `insertBatch` once a
+/// drain crosses `BULK_THRESHOLD` and the merge rebuild beats that
+/// many descents. Exits once stopped and empty
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare, class Aggregate>
+void BSTIngest<K, T, Compare, Aggregate>::drain() {
+  for(;;) {
+    size_t count = 0;
+    while(count <= mask) {
+      Slot& slot = ring[dequeuePos & mask];
+      intptr_t lag = (intptr_t) slot.sequence.load(std::memory_order_acquire) - (intptr_t) (dequeuePos + 1);
+      if(lag < 0) {
+        break; // nothing published yet
+      }
+      batch[count].first = std::move(slot.weight);
+      batch[count].second = std::move(slot.value);
+      count++;
+      slot.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+      dequeuePos++;
+    }
+    if(!count) {
+      if(!running.load(std::memory_order_acquire) &&
+         enqueuePos.load(std::memory_order_acquire) == dequeuePos) {
+        return;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    if(count >= BULK_THRESHOLD) {
+      tree.insertBatch(batch, count);
+    }
+    else {
+      for(size_t i = 0; i < count; i++) {
+        tree.insert(tree.getRoot(), std::move(batch[i].first), std::move(batch[i].second));
+      }
+    }
+    applied.store(dequeuePos, std::memory_order_release);
+  }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+/////////////////////////////////////////////////
+/// Memory-Mapped Snapshot
+/// Serves lookups directly against a snapshot file written by
+/// `BST<K, T, Compare>::save` with zero deserialization: the file is mmap'd
+/// read-only and `getMapped` binary-searches the weights array in
+/// place, so loading costs page-fault time and multiple processes
+/// share one physical copy of the image. Only valid for trivially
+/// copyable `T`, matching the snapshot format itself
+/// @author Derick Vigne
+/// @copyright MIT License
+/////////////////////////////////////////////////
+
+template <class K, class T = K, class Compare = std::less<K>>
+class MappedBST {
+private:
+  void* base = NULL; ///< Start of the mapped image
+  size_t length = 0; ///< Length of the mapping in bytes
+  const K* weights = NULL; ///< Weights array inside the image, ascending
+  Compare comp; ///< Ordering used for lookups, matching the source tree
+  const T* values = NULL; ///< Values array inside the image, parallel to the weights
+  size_t count = 0; ///< Number of entries in the image
+
+public:
+  MappedBST(const char* path); ///< Maps a snapshot file into memory
+  MappedBST(MappedBST&& other);
+  MappedBST(const MappedBST&) = delete;
+  ~MappedBST();
+  bool valid() { return base != NULL; } ///< Whether the file mapped and validated cleanly
+  size_t size() { return count; } ///< Number of entries in the snapshot
+  const T& getMapped(K weight); ///< Looks up a value by weight against the mapped image
+};
+
+/////////////////////////////////////////////////
+/// @param path Snapshot file to map
+/// @return `void`
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare>
+MappedBST<K, T, Compare>::MappedBST(const char* path) {
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    return;
+  }
+  struct stat info;
+  if(fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(BSTSnapshotHeader)) {
+    close(fd);
+    return;
+  }
+  void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // the mapping keeps its own reference to the file
+  if(mapped == MAP_FAILED) {
+    return;
+  }
+  const BSTSnapshotHeader* header = (const BSTSnapshotHeader*) mapped;
+  // division-based bounds checks so a crafted count cannot wrap the
+  // arithmetic past the file size; both columns must fit entirely
+  size_t fileSize = (size_t) info.st_size;
+  if(memcmp(header->magic, BST_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+     || header->keySize != sizeof(K)
+     || header->valueSize != sizeof(T)
+     || header->count > (fileSize - sizeof(BSTSnapshotHeader)) / sizeof(K)
+     || header->valueOffset < sizeof(BSTSnapshotHeader) + header->count * sizeof(K)
+     || header->valueOffset > fileSize
+     || header->count > (fileSize - (size_t) header->valueOffset) / sizeof(T)) {
+    munmap(mapped, info.st_size);
+    return;
+  }
+  base = mapped;
+  length = info.st_size;
+  count = header->count;
+  weights = (const K*) ((const char*) mapped + sizeof(BSTSnapshotHeader));
+  values = (const T*) ((const char*) mapped + header->valueOffset);
+}
+
+template <class K, class T, class Compare>
+MappedBST<K, T, Compare>::MappedBST(MappedBST&& other) {
+  base = other.base;
+  length = other.length;
+  weights = other.weights;
+  values = other.values;
+  count = other.count;
+  other.base = NULL;
+  other.length = 0;
+  other.weights = NULL;
+  other.values = NULL;
+  other.count = 0;
+}
+
+template <class K, class T, class Compare>
+MappedBST<K, T, Compare>::~MappedBST() {
+  if(base) {
+    munmap(base, length);
+  }
+}
+
+/////////////////////////////////////////////////
+/// @description Binary-searches the mapped weights array in place;
+/// nothing is copied or deserialized, so cold pages fault in on
+/// demand and hot lookups run straight out of the page cache
+/// @param weight Weight to look up
+/// @return `const T&` Reference to the value inside the mapped image
+/// @throws OutOfBoundsException If the weight is not present
+/////////////////////////////////////////////////
+
+template <class K, class T, class Compare>
+const T& MappedBST<K, T, Compare>::getMapped(K weight) {
+  const K* position = std::lower_bound(weights, weights + count, weight, comp);
+  if(position == weights + count || comp(weight, *position)) {
+    throw OutOfBoundsException();
+  }
+  return values[position - weights];
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
 
 #endif
@@ -0,0 +1,168 @@
+/////////////////////////////////////////////////
+/// BST Microbenchmark Suite
+/// Self-contained perf harness for the core tree operations. Each
+/// scenario reports wall time per operation and throughput so
+/// changes to insert/getNode/deleteNode/traverse can be compared
+/// run-over-run; pin the process and fix the CPU governor for
+/// stable numbers, and wrap the binary in `perf stat` when cycle
+/// and cache-miss counters are wanted. Build and run with
+/// `make run` in this directory
+/// @author Derick Vigne
+/// @copyright MIT License
+/////////////////////////////////////////////////
+
+#include "../BST.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::mt19937 rng(12345); // fixed seed: runs must be comparable
+
+static double now() {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static volatile long long sink = 0; // defeats dead-code elimination
+
+static void report(const char* name, size_t ops, double seconds) {
+  printf("%-40s %12zu ops %10.1f ns/op %12.0f ops/s\n",
+         name, ops, seconds / ops * 1e9, ops / seconds);
+}
+
+/////////////////////////////////////////////////
+/// Insert order scenarios: sorted ingest is the adversarial case
+/// that used to degenerate the tree into a list; random is the
+/// friendly case; zigzag alternates ends to stress rotations
+/////////////////////////////////////////////////
+
+static void benchInsert(const char* name, const std::vector<int>& weights) {
+  BST<int> tree(weights[0], weights[0]);
+  double start = now();
+  for (size_t i = 1; i < weights.size(); i++) {
+    tree.insert(tree.getRoot(), weights[i], weights[i]);
+  }
+  report(name, weights.size() - 1, now() - start);
+}
+
+static void benchLookup(size_t treeSize, size_t lookups) {
+  std::vector<int> weights(treeSize);
+  for (size_t i = 0; i < treeSize; i++) weights[i] = (int) i;
+  std::shuffle(weights.begin(), weights.end(), rng);
+  BST<int> tree(weights[0], weights[0]);
+  for (size_t i = 1; i < treeSize; i++) tree.insert(tree.getRoot(), weights[i], weights[i]);
+
+  std::uniform_int_distribution<int> pick(0, (int) treeSize - 1);
+  double start = now();
+  for (size_t i = 0; i < lookups; i++) {
+    sink += tree.getNode(tree.getRoot(), pick(rng))->value;
+  }
+  char label[64];
+  snprintf(label, sizeof(label), "getNode (%zuk nodes)", treeSize / 1000);
+  report(label, lookups, now() - start);
+
+  FrozenBST<int> frozen = tree.freeze();
+  start = now();
+  for (size_t i = 0; i < lookups; i++) {
+    sink += frozen.getFrozen(pick(rng));
+  }
+  snprintf(label, sizeof(label), "getFrozen (%zuk nodes)", treeSize / 1000);
+  report(label, lookups, now() - start);
+}
+
+static void benchMixed(size_t treeSize, size_t ops, int readPercent) {
+  BST<int> tree(0, 0);
+  for (size_t i = 1; i < treeSize; i++) tree.insert(tree.getRoot(), (int) i, (int) i);
+  std::uniform_int_distribution<int> pick(0, (int) treeSize - 1);
+  std::uniform_int_distribution<int> dice(0, 99);
+  double start = now();
+  for (size_t i = 0; i < ops; i++) {
+    int weight = pick(rng);
+    if (dice(rng) < readPercent) {
+      try { sink += tree.getNode(tree.getRoot(), weight)->value; }
+      catch (OutOfBoundsException&) {}
+    }
+    else {
+      tree.insert(tree.getRoot(), weight, weight);
+    }
+  }
+  char label[64];
+  snprintf(label, sizeof(label), "mixed %d%% read (%zuk nodes)", readPercent, treeSize / 1000);
+  report(label, ops, now() - start);
+}
+
+static void benchChurn(size_t treeSize, size_t cycles) {
+  BST<int> tree(0, 0);
+  for (size_t i = 1; i < treeSize; i++) tree.insert(tree.getRoot(), (int) i, (int) i);
+  std::uniform_int_distribution<int> pick(0, (int) treeSize - 1);
+  double start = now();
+  for (size_t i = 0; i < cycles; i++) {
+    int weight = pick(rng);
+    try { tree.deleteNode(tree.getRoot(), weight); }
+    catch (OutOfBoundsException&) {}
+    tree.insert(tree.getRoot(), weight, weight);
+  }
+  char label[64];
+  snprintf(label, sizeof(label), "delete+reinsert churn (%zuk nodes)", treeSize / 1000);
+  report(label, cycles * 2, now() - start);
+}
+
+static void benchTraversal(size_t treeSize) {
+  BST<int> tree(0, 0);
+  for (size_t i = 1; i < treeSize; i++) tree.insert(tree.getRoot(), (int) i, (int) i);
+  double start = now();
+  long long total = 0;
+  for (auto entry : tree) {
+    total += entry.first;
+  }
+  sink += total;
+  char label[64];
+  snprintf(label, sizeof(label), "iterator walk (%zuk nodes)", treeSize / 1000);
+  report(label, treeSize, now() - start);
+
+  start = now();
+  total = 0;
+  tree.traverseRange(0, (int) treeSize, [&](int weight, int&) { total += weight; });
+  sink += total;
+  snprintf(label, sizeof(label), "traverseRange full (%zuk nodes)", treeSize / 1000);
+  report(label, treeSize, now() - start);
+}
+
+static void benchBulkLoad(size_t count) {
+  std::vector<std::pair<int, int>> sorted(count);
+  for (size_t i = 0; i < count; i++) sorted[i] = { (int) i, (int) i };
+  double start = now();
+  BST<int> tree(sorted.data(), sorted.size());
+  sink += tree.getRoot()->weight;
+  char label[64];
+  snprintf(label, sizeof(label), "bulk load sorted (%zuk pairs)", count / 1000);
+  report(label, count, now() - start);
+}
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? (size_t) atoll(argv[1]) : 1000000;
+
+  std::vector<int> sorted(n), random(n), zigzag(n);
+  for (size_t i = 0; i < n; i++) sorted[i] = (int) i;
+  random = sorted;
+  std::shuffle(random.begin(), random.end(), rng);
+  for (size_t i = 0; i < n; i++) {
+    zigzag[i] = (i % 2) ? (int) (n - 1 - i / 2) : (int) (i / 2);
+  }
+
+  benchInsert("insert sorted ascending", sorted);
+  benchInsert("insert random", random);
+  benchInsert("insert zigzag", zigzag);
+  benchBulkLoad(n);
+  benchLookup(1000, 1000000);
+  benchLookup(n, 1000000);
+  benchMixed(n, 1000000, 95);
+  benchMixed(n, 1000000, 50);
+  benchChurn(n, 500000);
+  benchTraversal(n);
+  return 0;
+}